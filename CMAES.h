@@ -0,0 +1,251 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include "Optimizer.h"
+#include "Random.h"
+
+// Covariance matrix adaptation evolution strategy (Hansen's (mu/mu_w, lambda)-CMA-ES), maximising fitness.
+// Matrices are dense row-major doubles; the eigendecomposition of C (cyclic Jacobi) is only refreshed every
+// few generations, so a generation costs O(lambda * n^2) for sampling plus O(mu * n^2) for the update.
+class CMAES : public Optimizer {
+	int n;
+	int lambda;
+	int mu;
+	std::vector<double> weights;
+	double mueff, cc, cs, c1, cmu, damps, chiN;
+
+	double sigma;
+	std::vector<double> mean;
+	std::vector<double> pc, ps;
+	std::vector<double> C, B, D, invsqrtC;
+	long long evaluations = 0;
+	long long eigenEvaluations = 0;
+
+	std::vector<std::vector<double>> samples;
+	std::vector<float> bestWeights;
+	float bestFitness = -1e30f;
+	Rng rng;
+
+	// y = M x for a row-major n x n matrix
+	void multiply(const std::vector<double>& M, const double* x, double* y) const {
+		for (int i = 0; i < n; i++) {
+			const double* row = &M[i * n];
+			double sum = 0;
+			for (int j = 0; j < n; j++) {
+				sum += row[j] * x[j];
+			}
+			y[i] = sum;
+		}
+	}
+
+	// Cyclic Jacobi eigendecomposition of the symmetric matrix C: C = B diag(eigenvalues) B^T
+	static void eigen(int n, std::vector<double> A, std::vector<double>& V, std::vector<double>& eigenvalues) {
+		V.assign(n * n, 0);
+		for (int i = 0; i < n; i++) {
+			V[i * n + i] = 1;
+		}
+		for (int sweep = 0; sweep < 50; sweep++) {
+			double off = 0;
+			for (int p = 0; p < n; p++) {
+				for (int q = p + 1; q < n; q++) {
+					off += A[p * n + q] * A[p * n + q];
+				}
+			}
+			if (off < 1e-22)
+				break;
+
+			for (int p = 0; p < n; p++) {
+				for (int q = p + 1; q < n; q++) {
+					double apq = A[p * n + q];
+					if (std::abs(apq) < 1e-300)
+						continue;
+					double theta = (A[q * n + q] - A[p * n + p]) / (2 * apq);
+					double t = (theta >= 0 ? 1 : -1) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+					double c = 1 / std::sqrt(t * t + 1);
+					double s = t * c;
+					for (int k = 0; k < n; k++) {
+						double akp = A[k * n + p], akq = A[k * n + q];
+						A[k * n + p] = c * akp - s * akq;
+						A[k * n + q] = s * akp + c * akq;
+					}
+					for (int k = 0; k < n; k++) {
+						double apk = A[p * n + k], aqk = A[q * n + k];
+						A[p * n + k] = c * apk - s * aqk;
+						A[q * n + k] = s * apk + c * aqk;
+					}
+					for (int k = 0; k < n; k++) {
+						double vkp = V[k * n + p], vkq = V[k * n + q];
+						V[k * n + p] = c * vkp - s * vkq;
+						V[k * n + q] = s * vkp + c * vkq;
+					}
+				}
+			}
+		}
+		eigenvalues.resize(n);
+		for (int i = 0; i < n; i++) {
+			eigenvalues[i] = A[i * n + i];
+		}
+	}
+
+	void updateEigensystem() {
+		eigenEvaluations = evaluations;
+		for (int i = 0; i < n; i++) {
+			for (int j = 0; j < i; j++) {
+				C[i * n + j] = C[j * n + i];
+			}
+		}
+		std::vector<double> values;
+		eigen(n, C, B, values);
+		for (int i = 0; i < n; i++) {
+			D[i] = std::sqrt(std::max(values[i], 1e-20));
+		}
+		for (int i = 0; i < n; i++) {
+			for (int j = 0; j < n; j++) {
+				double sum = 0;
+				for (int k = 0; k < n; k++) {
+					sum += B[i * n + k] * B[j * n + k] / D[k];
+				}
+				invsqrtC[i * n + j] = sum;
+			}
+		}
+	}
+
+public:
+	// lambda <= 0 picks the usual 4 + 3 ln(n)
+	CMAES(const std::vector<float>& start, double sigma, int lambda, uint64_t seed)
+		: n(start.size()), sigma(sigma), rng(seed) {
+		this->lambda = lambda > 0 ? lambda : 4 + (int)(3 * std::log((double)n));
+		mu = this->lambda / 2;
+		for (int i = 0; i < mu; i++) {
+			weights.push_back(std::log(mu + 0.5) - std::log(i + 1.0));
+		}
+		double sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+		double sumSq = 0;
+		for (double& w : weights) {
+			w /= sum;
+			sumSq += w * w;
+		}
+		mueff = 1 / sumSq;
+
+		cc = (4 + mueff / n) / (n + 4 + 2 * mueff / n);
+		cs = (mueff + 2) / (n + mueff + 5);
+		c1 = 2 / ((n + 1.3) * (n + 1.3) + mueff);
+		cmu = std::min(1 - c1, 2 * (mueff - 2 + 1 / mueff) / ((n + 2) * (n + 2) + mueff));
+		damps = 1 + 2 * std::max(0.0, std::sqrt((mueff - 1) / (n + 1)) - 1) + cs;
+		chiN = std::sqrt((double)n) * (1 - 1.0 / (4 * n) + 1.0 / (21.0 * n * n));
+
+		mean.assign(start.begin(), start.end());
+		pc.assign(n, 0);
+		ps.assign(n, 0);
+		C.assign(n * n, 0);
+		B.assign(n * n, 0);
+		invsqrtC.assign(n * n, 0);
+		D.assign(n, 1);
+		for (int i = 0; i < n; i++) {
+			C[i * n + i] = B[i * n + i] = invsqrtC[i * n + i] = 1;
+		}
+		bestWeights = start;
+	}
+
+	int populationSize() const override {
+		return lambda;
+	}
+
+	void ask(std::vector<std::vector<float>>& population) override {
+		samples.resize(lambda);
+		population.resize(lambda);
+		std::vector<double> z(n), y(n);
+		for (int k = 0; k < lambda; k++) {
+			for (int i = 0; i < n; i++) {
+				z[i] = D[i] * rng.normal();
+			}
+			multiply(B, z.data(), y.data());
+			samples[k].resize(n);
+			population[k].resize(n);
+			for (int i = 0; i < n; i++) {
+				samples[k][i] = mean[i] + sigma * y[i];
+				population[k][i] = (float)samples[k][i];
+			}
+		}
+	}
+
+	void tell(const std::vector<float>& fitness) override {
+		evaluations += lambda;
+		std::vector<int> order(lambda);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](int a, int b) { return fitness[a] > fitness[b]; });
+		if (fitness[order[0]] > bestFitness) {
+			bestFitness = fitness[order[0]];
+			bestWeights.assign(samples[order[0]].begin(), samples[order[0]].end());
+		}
+
+		std::vector<double> old = mean;
+		std::fill(mean.begin(), mean.end(), 0.0);
+		for (int k = 0; k < mu; k++) {
+			const std::vector<double>& x = samples[order[k]];
+			for (int i = 0; i < n; i++) {
+				mean[i] += weights[k] * x[i];
+			}
+		}
+
+		std::vector<double> step(n), whitened(n);
+		for (int i = 0; i < n; i++) {
+			step[i] = (mean[i] - old[i]) / sigma;
+		}
+		multiply(invsqrtC, step.data(), whitened.data());
+		double csn = std::sqrt(cs * (2 - cs) * mueff);
+		double psNorm = 0;
+		for (int i = 0; i < n; i++) {
+			ps[i] = (1 - cs) * ps[i] + csn * whitened[i];
+			psNorm += ps[i] * ps[i];
+		}
+		psNorm = std::sqrt(psNorm);
+		bool hsig = psNorm / std::sqrt(1 - std::pow(1 - cs, 2.0 * evaluations / lambda)) / chiN < 1.4 + 2.0 / (n + 1);
+		double ccn = std::sqrt(cc * (2 - cc) * mueff);
+		for (int i = 0; i < n; i++) {
+			pc[i] = (1 - cc) * pc[i] + (hsig ? ccn * step[i] : 0);
+		}
+
+		// C = (1 - c1 - cmu) C + c1 (pc pc^T + correction) + cmu sum w_k y_k y_k^T, upper triangle only
+		double keep = 1 - c1 - cmu + (hsig ? 0 : c1 * cc * (2 - cc));
+		std::vector<std::vector<double>> y(mu, std::vector<double>(n));
+		for (int k = 0; k < mu; k++) {
+			const std::vector<double>& x = samples[order[k]];
+			for (int i = 0; i < n; i++) {
+				y[k][i] = (x[i] - old[i]) / sigma;
+			}
+		}
+		for (int i = 0; i < n; i++) {
+			double* row = &C[i * n];
+			for (int j = i; j < n; j++) {
+				row[j] = keep * row[j] + c1 * pc[i] * pc[j];
+			}
+			for (int k = 0; k < mu; k++) {
+				double wyi = cmu * weights[k] * y[k][i];
+				const double* yk = y[k].data();
+				for (int j = i; j < n; j++) {
+					row[j] += wyi * yk[j];
+				}
+			}
+		}
+
+		sigma *= std::exp((cs / damps) * (psNorm / chiN - 1));
+		// flat fitness (common early on: every bird hits the floor at the same time) says nothing about
+		// the direction, so widen the search instead of letting sigma collapse
+		if (fitness[order[0]] == fitness[order[(int)std::ceil(0.7 * (lambda - 1))]])
+			sigma *= std::exp(0.2 + cs / damps);
+
+		if (evaluations - eigenEvaluations > lambda / (c1 + cmu) / n / 10)
+			updateEigensystem();
+	}
+
+	const std::vector<float>& best() const override {
+		return bestWeights;
+	}
+
+	double stepSize() const {
+		return sigma;
+	}
+};
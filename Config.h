@@ -0,0 +1,190 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdint>
+#include <vector>
+
+// Run settings, optionally overridden from a "key = value" file ('#' starts a comment)
+struct Config {
+	int population = 100;
+	std::vector<int> brainShape = { 4,8,2 };
+	std::string genome = "weights";	// weights, seedchain (mutation only, mutationStep is the noise strength), neat (ga engine)
+	float addNodeChance = 0.03f;	// neat: chance a child splits a connection with a new node
+	float addConnectionChance = 0.05f;	// neat: chance a child gains a connection (brainShape gives only inputs and outputs)
+	std::string selection = "roulette";	// roulette, tournament, rank, sus, nsga2 (survival, flaps, sparsity)
+	int tournamentSize = 3;
+	float rankPressure = 1.5f;
+	float mutationChance = 0.05f;	// per weight
+	float mutationStep = 0.2f;
+	bool selfAdaptive = false;	// every genome carries its own mutationChance and mutationStep (these are the starting values)
+	uint64_t seed = 0;	// 0 picks one from the clock
+	int threads = 0;	// 0 uses every hardware thread
+	std::string checkpoint;	// population file, loaded at start and saved every checkpointInterval generations
+	int checkpointInterval = 50;
+	bool steadyState = false;	// replace each bird as it dies instead of breeding whole generations
+	bool fixedCourse = false;	// every generation flies the same course instead of a fresh one
+	int fitnessCache = 4096;	// headless runs skip genomes already flown on the course (entries, 0 = off)
+	bool racing = false;	// headless runs evaluate by successive halving instead of whole flights
+	float racingFirstRung = 4;	// seconds every bird flies before the first cut (just past the first pipe)
+	float racingKeep = 0.5f;	// share promoted at each rung (the next rung is 1/racingKeep times longer)
+	bool surrogate = false;	// predict children's fitness and only fly the most promising ones
+	float surrogateKeep = 0.5f;	// share of children flown once the surrogate has warmed up
+	bool novelty = false;	// breed for novel behaviour instead of survival time
+	int noveltyK = 15;	// neighbours a behaviour is compared with
+	int noveltyArchive = 5;	// most novel behaviours archived per generation
+	bool speciation = false;	// share fitness within species of similar genomes (ga engine)
+	float speciesThreshold = 0;	// starting compatibility distance (mean absolute weight difference) within a species, 0 calibrates it from the first generation
+	int speciesTarget = 8;	// species count the threshold adapts towards (0 keeps it fixed)
+
+	// MAP-Elites (--map): population is the batch size
+	int mapResolution = 32;	// cells per behaviour axis
+	std::string mapFile;	// grid file, kept and resumed between runs (in memory when empty)
+	std::string engine = "ga";	// ga, cmaes, es, de (population is the number of samples per generation; de also reflies its targets unless fixedCourse)
+	float engineSigma = 0.5f;	// initial step size of the weight-vector engines
+	float engineRate = 0.03f;	// es learning rate
+	int noiseTableSize = 1 << 22;	// es shared noise values
+	std::string deStrategy = "rand1bin";	// de mutation: rand1bin, currentToBest
+	float deWeight = 0.5f;	// de differential weight F
+	float deCrossover = 0.9f;	// de crossover rate CR
+
+	// the course
+	float speed = 50;	// pipe speed (pixels per second)
+	int obstacleGap = 300;	// horizontal distance between pipes
+
+	// headless runs
+	int generations = 1000;
+	float maxGenTime = 120;	// seconds of simulated time before a generation is cut off
+
+	// island model (--islands)
+	int islands = 4;
+	std::string topology = "ring";	// ring, full, random
+	int migrationInterval = 10;	// generations between migrations
+	int migrationCount = 2;	// best birds sent per migration
+
+	// distributed islands (--islands --node i): every process lists the same nodes in the same order,
+	// one "node = host:port" or "node = unix:/path" line each
+	std::vector<std::string> nodes;
+
+	// hyperparameter sweep (--sweep file): every trial runs on one thread, threads trials at a time
+	int sweepSamples = 0;	// random points to try (0 tries the whole grid)
+	std::string sweepResults = "sweep.csv";	// per-generation summaries of every trial
+	bool sweepEarlyStop = false;	// stop trials that fall behind, by asynchronous successive halving
+	int ashaFirstRung = 20;	// generations every trial runs before its first judgement
+	int ashaReduction = 3;	// share kept at each rung is 1/ashaReduction; rungs are ashaReduction times apart
+
+	// evaluation farm (--master / --worker)
+	std::string farm = "127.0.0.1:47100";	// the master listens here, workers connect here
+	int batchSize = 50;	// genomes per work item
+	int workTimeout = 30;	// seconds before a batch is given to another worker
+
+	bool set(const std::string& key, const std::string& value) {
+		std::istringstream in(value);
+		if (key == "population") in >> population;
+		else if (key == "brainShape") brainShape = parseList(value);
+		else if (key == "genome") in >> genome;
+		else if (key == "selection") in >> selection;
+		else if (key == "tournamentSize") in >> tournamentSize;
+		else if (key == "rankPressure") in >> rankPressure;
+		else if (key == "mutationChance") in >> mutationChance;
+		else if (key == "mutationStep") in >> mutationStep;
+		else if (key == "addNodeChance") in >> addNodeChance;
+		else if (key == "addConnectionChance") in >> addConnectionChance;
+		else if (key == "selfAdaptive") in >> selfAdaptive;
+		else if (key == "seed") in >> seed;
+		else if (key == "threads") in >> threads;
+		else if (key == "checkpoint") in >> checkpoint;
+		else if (key == "checkpointInterval") {
+			int interval = 0;
+			in >> interval;
+			if (interval >= 1)
+				checkpointInterval = interval;
+			else
+				std::cout << "checkpointInterval must be at least 1, keeping " << checkpointInterval << '\n';
+		}
+		else if (key == "steadyState") in >> steadyState;
+		else if (key == "fixedCourse") in >> fixedCourse;
+		else if (key == "fitnessCache") in >> fitnessCache;
+		else if (key == "racing") in >> racing;
+		else if (key == "racingFirstRung") in >> racingFirstRung;
+		else if (key == "racingKeep") in >> racingKeep;
+		else if (key == "surrogate") in >> surrogate;
+		else if (key == "surrogateKeep") in >> surrogateKeep;
+		else if (key == "novelty") in >> novelty;
+		else if (key == "noveltyK") in >> noveltyK;
+		else if (key == "noveltyArchive") in >> noveltyArchive;
+		else if (key == "speciation") in >> speciation;
+		else if (key == "speciesThreshold") in >> speciesThreshold;
+		else if (key == "speciesTarget") in >> speciesTarget;
+		else if (key == "mapResolution") in >> mapResolution;
+		else if (key == "mapFile") in >> mapFile;
+		else if (key == "engine") in >> engine;
+		else if (key == "engineSigma") in >> engineSigma;
+		else if (key == "engineRate") in >> engineRate;
+		else if (key == "noiseTableSize") in >> noiseTableSize;
+		else if (key == "deStrategy") in >> deStrategy;
+		else if (key == "deWeight") in >> deWeight;
+		else if (key == "deCrossover") in >> deCrossover;
+		else if (key == "speed") in >> speed;
+		else if (key == "obstacleGap") in >> obstacleGap;
+		else if (key == "generations") in >> generations;
+		else if (key == "maxGenTime") in >> maxGenTime;
+		else if (key == "islands") in >> islands;
+		else if (key == "topology") in >> topology;
+		else if (key == "migrationInterval") in >> migrationInterval;
+		else if (key == "migrationCount") in >> migrationCount;
+		else if (key == "node") nodes.push_back(value);
+		else if (key == "sweepSamples") in >> sweepSamples;
+		else if (key == "sweepResults") in >> sweepResults;
+		else if (key == "sweepEarlyStop") in >> sweepEarlyStop;
+		else if (key == "ashaFirstRung") in >> ashaFirstRung;
+		else if (key == "ashaReduction") in >> ashaReduction;
+		else if (key == "farm") in >> farm;
+		else if (key == "batchSize") in >> batchSize;
+		else if (key == "workTimeout") in >> workTimeout;
+		else return false;
+		return true;
+	}
+
+	bool load(const std::string& path) {
+		std::ifstream file(path);
+		if (!file)
+			return false;
+
+		std::string line;
+		while (std::getline(file, line)) {
+			line = line.substr(0, line.find('#'));
+			size_t eq = line.find('=');
+			if (eq == std::string::npos)
+				continue;
+
+			std::string key = trim(line.substr(0, eq));
+			std::string value = trim(line.substr(eq + 1));
+			if (!set(key, value))
+				std::cout << "Unknown config key: " << key << '\n';
+		}
+		return true;
+	}
+
+	static std::string trim(const std::string& s) {
+		size_t a = s.find_first_not_of(" \t\r");
+		if (a == std::string::npos)
+			return "";
+		size_t b = s.find_last_not_of(" \t\r");
+		return s.substr(a, b - a + 1);
+	}
+
+private:
+	// "4,8,2" -> {4,8,2}
+	static std::vector<int> parseList(const std::string& s) {
+		std::vector<int> list;
+		std::istringstream in(s);
+		std::string item;
+		while (std::getline(in, item, ',')) {
+			list.push_back(std::stoi(item));
+		}
+		return list;
+	}
+
+};
@@ -0,0 +1,151 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "Optimizer.h"
+#include "Random.h"
+#include "ThreadPool.h"
+
+// Differential evolution on flat weight vectors (rand/1/bin or current-to-best/1/bin).
+// The first ask() returns the initial population itself; after that every ask() returns one trial per
+// target and tell() keeps each trial that does at least as well as its target. Every target is replaced
+// independently of the others, so there is no selection step to serialise on.
+// A target's fitness is only comparable with its trial's when both flew the same course. Unless the course is
+// fixed, every ask() after the first therefore returns the targets again followed by their trials (2 * np
+// vectors, twice the flights), and tell() compares each trial with its target's fitness on this course.
+// Vectors live in one contiguous buffer (row i = member i); trials are built in parallel with a random
+// stream per trial, so the result doesn't depend on the thread count.
+class DifferentialEvolution : public Optimizer {
+	int np;
+	int n;
+	float F;
+	float CR;
+	bool toBest;
+	bool reevaluate;
+	std::vector<float> targets;
+	std::vector<float> targetFitness;
+	std::vector<float> trials;
+	bool evaluated = false;
+	int bestIndex = 0;
+	std::vector<float> bestWeights;
+	Rng rng;
+	ThreadPool* pool = nullptr;
+
+	// distinct member indices other than i
+	void pick(int i, Rng& r, int* out, int count) const {
+		for (int k = 0; k < count; k++) {
+			int x;
+			do {
+				x = r.range(0, np - 1);
+			} while (x == i || std::find(out, out + k, x) != out + k);
+			out[k] = x;
+		}
+	}
+
+	void makeTrial(int i, Rng& r) {
+		float* u = &trials[i * n];
+		const float* x = &targets[i * n];
+		int idx[3];
+		if (toBest) {
+			pick(i, r, idx, 2);
+			const float* best = &targets[bestIndex * n];
+			const float* a = &targets[idx[0] * n];
+			const float* b = &targets[idx[1] * n];
+			for (int j = 0; j < n; j++) {
+				u[j] = x[j] + F * (best[j] - x[j]) + F * (a[j] - b[j]);
+			}
+		}
+		else {
+			pick(i, r, idx, 3);
+			const float* a = &targets[idx[0] * n];
+			const float* b = &targets[idx[1] * n];
+			const float* c = &targets[idx[2] * n];
+			for (int j = 0; j < n; j++) {
+				u[j] = a[j] + F * (b[j] - c[j]);
+			}
+		}
+
+		// binomial crossover: each weight falls back to the target with probability 1 - CR (skipping
+		// ahead geometrically), except one random weight that always comes from the mutant
+		int keep = r.range(0, n - 1);
+		for (int j = r.geometric(1 - CR); j < n; ) {
+			if (j != keep)
+				u[j] = x[j];
+			int skip = r.geometric(1 - CR);
+			if (skip >= n - j)
+				break;
+			j += skip + 1;
+		}
+	}
+
+public:
+	// strategy is "rand1bin" or "currentToBest"; starting vectors are uniform in [-1,1). fixedCourse says every
+	// generation flies the same course, so targets keep the fitness they were last scored with.
+	DifferentialEvolution(int dimensions, int populationSize, float F, float CR, const std::string& strategy, bool fixedCourse, uint64_t seed)
+		: np(std::max(4, populationSize)), n(dimensions), F(F), CR(CR), toBest(strategy == "currentToBest"), reevaluate(!fixedCourse), rng(seed) {
+		targets.resize(np * n);
+		for (float& w : targets) {
+			w = rng.uniform2();
+		}
+		targetFitness.assign(np, 0);
+		trials.resize(np * n);
+		bestWeights.assign(targets.begin(), targets.begin() + n);
+	}
+
+	void setThreadPool(ThreadPool* p) {
+		pool = p;
+	}
+
+	int populationSize() const override {
+		return np;
+	}
+
+	void ask(std::vector<std::vector<float>>& population) override {
+		int offset = evaluated && reevaluate ? np : 0;
+		population.resize(offset + np);
+		if (!evaluated || reevaluate) {
+			for (int i = 0; i < np; i++) {
+				population[i].assign(targets.begin() + i * n, targets.begin() + (i + 1) * n);
+			}
+			if (!evaluated)
+				return;
+		}
+
+		uint64_t genSeed = rng.next();
+		auto build = [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				Rng trialRng = Rng::stream(genSeed, i);
+				makeTrial(i, trialRng);
+				population[offset + i].assign(trials.begin() + i * n, trials.begin() + (i + 1) * n);
+			}
+		};
+		if (pool)
+			pool->parallelFor(np, build);
+		else
+			build(0, np);
+	}
+
+	void tell(const std::vector<float>& fitness) override {
+		if (!evaluated) {
+			targetFitness = fitness;
+			evaluated = true;
+		}
+		else {
+			int offset = reevaluate ? np : 0;
+			for (int i = 0; i < np; i++) {
+				if (reevaluate)
+					targetFitness[i] = fitness[i];
+				if (fitness[offset + i] >= targetFitness[i]) {
+					std::copy(trials.begin() + i * n, trials.begin() + (i + 1) * n, targets.begin() + i * n);
+					targetFitness[i] = fitness[offset + i];
+				}
+			}
+		}
+		bestIndex = std::max_element(targetFitness.begin(), targetFitness.end()) - targetFitness.begin();
+		bestWeights.assign(targets.begin() + bestIndex * n, targets.begin() + (bestIndex + 1) * n);
+	}
+
+	const std::vector<float>& best() const override {
+		return bestWeights;
+	}
+};
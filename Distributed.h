@@ -0,0 +1,171 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include "Net.h"
+#include "Serialize.h"
+#include "Simulation.h"
+#include "MigrationQueue.h"
+
+// Migrant exchange between the processes of a distributed island run.
+// Every process is given the same node list (Config "node = address" lines, same order) and its own index.
+// It listens on its own address and sends migrants to the peers picked by the topology.
+// A dead peer only costs a failed send: its connection is dropped and retried every retrySeconds.
+//
+// message: u8 type (1 = migrants), u16 count, then per migrant f32 fitness and the genome (Bird::writeGenome)
+class PeerNetwork {
+	static const uint8_t msgMigrants = 1;
+	static constexpr int retrySeconds = 2;
+
+	std::vector<std::string> nodes;
+	int self;
+	Bird prototype;
+	MigrationQueue<Bird>& inbox;
+
+	Socket listener;
+	std::thread acceptThread;
+	std::mutex incomingMutex;
+	std::vector<std::shared_ptr<Socket>> incoming;
+	std::vector<std::thread> readers;
+	std::vector<Socket> outgoing;
+	std::vector<std::chrono::steady_clock::time_point> retryAt;
+	std::atomic<bool> running{ false };
+
+	void acceptLoop() {
+		while (running) {
+			std::shared_ptr<Socket> peer = std::make_shared<Socket>(listener.accept());
+			if (!peer->valid())
+				continue;
+			std::lock_guard<std::mutex> lock(incomingMutex);
+			if (!running)
+				break;
+			incoming.push_back(peer);
+			readers.emplace_back(&PeerNetwork::readLoop, this, peer);
+		}
+	}
+
+	void readLoop(std::shared_ptr<Socket> peer) {
+		std::vector<uint8_t> frame;
+		Bird migrant = prototype;
+		while (running && peer->recvFrame(frame)) {
+			ByteReader in(frame);
+			if (in.u8() != msgMigrants)
+				continue;
+			int count = in.u16();
+			SeedChain::ReadTable chains;
+			for (int i = 0; i < count && in.ok; i++) {
+				migrant.fitness = in.f32();
+				if (!migrant.readGenome(in, prototype.getBrain().getShape(), chains))
+					break;
+				inbox.push(migrant);
+				received++;
+			}
+		}
+		peer->close();
+	}
+
+public:
+	std::atomic<int> sent{ 0 };
+	std::atomic<int> received{ 0 };
+
+	PeerNetwork(const std::vector<std::string>& nodes, int self, const Bird& prototype, MigrationQueue<Bird>& inbox)
+		: nodes(nodes), self(self), prototype(prototype), inbox(inbox), outgoing(nodes.size()), retryAt(nodes.size()) {}
+
+	~PeerNetwork() {
+		stop();
+	}
+
+	bool start() {
+		if (self < 0 || self >= nodes.size()) {
+			std::cout << "Node " << self << " is not in the node list\n";
+			return false;
+		}
+		listener = Socket::listen(nodes[self]);
+		if (!listener.valid()) {
+			std::cout << "Can't listen on " << nodes[self] << '\n';
+			return false;
+		}
+		running = true;
+		acceptThread = std::thread(&PeerNetwork::acceptLoop, this);
+		return true;
+	}
+
+	void stop() {
+		if (!running)
+			return;
+		running = false;
+		listener.shutdown();
+		listener.close();
+		acceptThread.join();
+		std::lock_guard<std::mutex> lock(incomingMutex);
+		for (auto& peer : incoming) {
+			peer->shutdown();
+		}
+		for (std::thread& t : readers) {
+			t.join();
+		}
+		incoming.clear();
+		readers.clear();
+	}
+
+	// peers to send to this time (ring: the next node, full: all other nodes, random: one other node)
+	std::vector<int> targets(const std::string& topology, Rng& rng) const {
+		int n = nodes.size();
+		std::vector<int> list;
+		if (n < 2)
+			return list;
+		if (topology == "full") {
+			for (int i = 0; i < n; i++) {
+				if (i != self)
+					list.push_back(i);
+			}
+		}
+		else if (topology == "random") {
+			int to = rng.range(0, n - 2);
+			list.push_back(to >= self ? to + 1 : to);
+		}
+		else {
+			list.push_back((self + 1) % n);
+		}
+		return list;
+	}
+
+	// Sends migrants to one peer. Only call from one thread at a time.
+	bool send(int peer, const std::vector<const Bird*>& migrants) {
+		auto now = std::chrono::steady_clock::now();
+		Socket& s = outgoing[peer];
+		if (!s.valid()) {
+			if (now < retryAt[peer])
+				return false;
+			s = Socket::connect(nodes[peer]);
+			if (!s.valid()) {
+				retryAt[peer] = now + std::chrono::seconds(retrySeconds);
+				return false;
+			}
+			s.setSendTimeout(retrySeconds);
+		}
+
+		ByteWriter out;
+		out.u8(msgMigrants);
+		out.u16(migrants.size());
+		SeedChain::WriteTable chains;
+		for (const Bird* b : migrants) {
+			out.f32(b->fitness);
+			b->writeGenome(out, chains);
+		}
+		if (!s.sendFrame(out.bytes)) {
+			std::cout << "Lost peer " << nodes[peer] << '\n';
+			s.close();
+			retryAt[peer] = now + std::chrono::seconds(retrySeconds);
+			return false;
+		}
+		sent += migrants.size();
+		return true;
+	}
+};
+constexpr int PeerNetwork::retrySeconds;
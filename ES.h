@@ -0,0 +1,170 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include "Optimizer.h"
+#include "Random.h"
+
+// Precomputed N(0,1) values. A perturbation is a slice of the table starting at some offset, so it can be
+// named by one integer. Tables are immutable once built and shared by everyone in the process asking for
+// the same (seed, size).
+class NoiseTable {
+	std::vector<float> noise;
+	uint64_t tableSeed;
+
+public:
+	NoiseTable(uint64_t seed, int size) : noise(size), tableSeed(seed) {
+		Rng rng(seed);
+		for (float& x : noise) {
+			x = rng.normal();
+		}
+	}
+
+	static std::shared_ptr<const NoiseTable> shared(uint64_t seed, int size) {
+		static std::mutex mutex;
+		static std::map<std::pair<uint64_t, int>, std::weak_ptr<const NoiseTable>> tables;
+		std::lock_guard<std::mutex> lock(mutex);
+		std::weak_ptr<const NoiseTable>& slot = tables[{ seed, size }];
+		std::shared_ptr<const NoiseTable> table = slot.lock();
+		if (!table) {
+			table = std::make_shared<const NoiseTable>(seed, size);
+			slot = table;
+		}
+		return table;
+	}
+
+	const float* at(uint32_t offset) const {
+		return &noise[offset];
+	}
+
+	int size() const {
+		return noise.size();
+	}
+
+	uint64_t seed() const {
+		return tableSeed;
+	}
+};
+
+// OpenAI-style evolution strategy: one parameter vector theta, lambda/2 antithetic pairs theta +- sigma * eps
+// per generation with eps read from a shared NoiseTable, centred-rank fitness shaping and an Adam step
+// along the estimated gradient.
+// Member i is fully described by perturbation(i) (table offset << 1 | negative), so anyone holding the
+// table and theta rebuilds it with apply() - remote workers only need integers (see EvaluationFarm).
+class EvolutionStrategy : public Optimizer {
+	std::shared_ptr<const NoiseTable> table;
+	std::vector<float> theta;
+	float sigma;
+	float rate;
+	int lambda;
+	std::vector<uint32_t> codes;
+	Rng rng;
+
+	std::vector<float> gradient, m, v;
+	int steps = 0;
+	std::vector<float> bestWeights;
+	float bestFitness = -1e30f;
+
+public:
+	EvolutionStrategy(const std::vector<float>& start, float sigma, float rate, int lambda, std::shared_ptr<const NoiseTable> table, uint64_t seed)
+		: table(table), theta(start), sigma(sigma), rate(rate), lambda(std::max(2, lambda / 2 * 2)), rng(seed),
+		gradient(start.size()), m(start.size()), v(start.size()), bestWeights(start) {}
+
+	// out = theta + sigma * eps (or - for odd codes)
+	static void apply(const std::vector<float>& theta, const NoiseTable& table, uint32_t code, float sigma, std::vector<float>& out) {
+		const float* eps = table.at(code >> 1);
+		float s = code & 1 ? -sigma : sigma;
+		int n = theta.size();
+		out.resize(n);
+		for (int i = 0; i < n; i++) {
+			out[i] = theta[i] + s * eps[i];
+		}
+	}
+
+	int populationSize() const override {
+		return lambda;
+	}
+
+	void ask(std::vector<std::vector<float>>& population) override {
+		population.resize(lambda);
+		codes.resize(lambda);
+		int maxOffset = table->size() - (int)theta.size();
+		for (int k = 0; k < lambda; k += 2) {
+			uint32_t offset = rng.range(0, maxOffset);
+			codes[k] = offset << 1;
+			codes[k + 1] = offset << 1 | 1;
+			apply(theta, *table, codes[k], sigma, population[k]);
+			apply(theta, *table, codes[k + 1], sigma, population[k + 1]);
+		}
+	}
+
+	void tell(const std::vector<float>& fitness) override {
+		// centred ranks in [-0.5, 0.5]; ties share their mean rank, so a flat generation doesn't move theta
+		std::vector<int> order(lambda);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](int a, int b) { return fitness[a] < fitness[b]; });
+		std::vector<float> shaped(lambda);
+		for (int i = 0; i < lambda;) {
+			int j = i;
+			while (j + 1 < lambda && fitness[order[j + 1]] == fitness[order[i]])
+				j++;
+			float rank = (i + j) / 2.0f / (lambda - 1) - 0.5f;
+			for (int k = i; k <= j; k++) {
+				shaped[order[k]] = rank;
+			}
+			i = j + 1;
+		}
+
+		int best = order.back();
+		if (fitness[best] > bestFitness) {
+			bestFitness = fitness[best];
+			apply(theta, *table, codes[best], sigma, bestWeights);
+		}
+
+		int n = theta.size();
+		std::fill(gradient.begin(), gradient.end(), 0.0f);
+		for (int k = 0; k < lambda; k += 2) {
+			float w = shaped[k] - shaped[k + 1];
+			const float* eps = table->at(codes[k] >> 1);
+			for (int i = 0; i < n; i++) {
+				gradient[i] += w * eps[i];
+			}
+		}
+
+		steps++;
+		const float beta1 = 0.9f, beta2 = 0.999f;
+		float scale = 1.0f / (lambda * sigma);
+		float stepRate = rate * std::sqrt(1 - std::pow(beta2, (float)steps)) / (1 - std::pow(beta1, (float)steps));
+		for (int i = 0; i < n; i++) {
+			float g = gradient[i] * scale;
+			m[i] = beta1 * m[i] + (1 - beta1) * g;
+			v[i] = beta2 * v[i] + (1 - beta2) * g * g;
+			theta[i] += stepRate * m[i] / (std::sqrt(v[i]) + 1e-8f);
+		}
+	}
+
+	const std::vector<float>& best() const override {
+		return bestWeights;
+	}
+
+	const std::vector<float>& parameters() const {
+		return theta;
+	}
+
+	const NoiseTable& noise() const {
+		return *table;
+	}
+
+	float stepSize() const {
+		return sigma;
+	}
+
+	// the noise code of member i of the last ask()
+	uint32_t perturbation(int i) const {
+		return codes[i];
+	}
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Config.h"
+#include "Optimizer.h"
+#include "CMAES.h"
+#include "ES.h"
+#include "DE.h"
+#include "NeuralNetwork.h"
+#include "Simulation.h"
+
+// The weight-vector engine config.engine names, or nullptr for the genetic algorithm (Evolution).
+// Engines start from a random brain and sample config.population weight vectors per generation.
+std::unique_ptr<Optimizer> makeOptimizer(const Config& config, Rng& rng, ThreadPool* pool = nullptr) {
+	if (config.engine == "cmaes") {
+		NeuralNetwork start(config.brainShape, true, rng);
+		return std::unique_ptr<Optimizer>(new CMAES(start.getWeights(), config.engineSigma, config.population, rng.next()));
+	}
+	if (config.engine == "es") {
+		NeuralNetwork start(config.brainShape, true, rng);
+		std::shared_ptr<const NoiseTable> table = NoiseTable::shared(rng.next(), std::max(config.noiseTableSize, (int)start.getWeights().size()));
+		return std::unique_ptr<Optimizer>(new EvolutionStrategy(start.getWeights(), config.engineSigma, config.engineRate, config.population, table, rng.next()));
+	}
+	if (config.engine == "de") {
+		int n = NeuralNetwork(config.brainShape, false).getWeights().size();
+		DifferentialEvolution* de = new DifferentialEvolution(n, config.population, config.deWeight, config.deCrossover, config.deStrategy, config.fixedCourse, rng.next());
+		de->setThreadPool(pool);
+		return std::unique_ptr<Optimizer>(de);
+	}
+	return nullptr;
+}
+
+// Asks the engine for the next generation and loads it into birds (resized to the engine's population)
+void askOptimizer(Optimizer& optimizer, std::vector<Bird>& birds, std::vector<std::vector<float>>& genomes) {
+	optimizer.ask(genomes);
+	birds.resize(genomes.size(), birds[0]);
+	for (int i = 0; i < birds.size(); i++) {
+		birds[i].setWeights(genomes[i]);
+	}
+}
+
+// Tells the engine how the birds of the last generation did
+void tellOptimizer(Optimizer& optimizer, const std::vector<Bird>& birds, std::vector<float>& fitness) {
+	fitness.resize(birds.size());
+	for (int i = 0; i < birds.size(); i++) {
+		fitness[i] = birds[i].fitness;
+	}
+	optimizer.tell(fitness);
+}
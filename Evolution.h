@@ -1,72 +1,124 @@
 #pragma once
 #include <memory>
 #include <vector>
+#include <type_traits>
+#include <algorithm>
 #include "Random.h"
+#include "Selection.h"
+#include "ThreadPool.h"
 
+// CRTP base of everything Evolution can evolve. Derived has to provide
+//   void breed(const Derived& a, const Derived& b, float mutationChance, float mutationStep, Rng& rng)
+// which overwrites *this with a child of a and b (reusing its own storage where it can).
+// It may also hide objectives() to give multi-objective selections more than its fitness, and shelve() to
+// free what a bred-from generation no longer needs until it is overwritten.
+// Dispatch is static - no virtual calls, no refcounts.
+template <typename Derived>
 class Agent {
 public:
-	float fitness;
-	virtual void mutate(float chance) {};
-	virtual std::shared_ptr<Agent> intercourse(const std::shared_ptr<Agent>& partner) = 0;
+	float fitness = 0;
+
+	// m values to maximise, fitness first
+	void objectives(float* out, int m) const {
+		out[0] = fitness;
+		std::fill(out + 1, out + m, 0.0f);
+	}
+
+	void shelve() {}
+
+	void breedFrom(const Derived& a, const Derived& b, float mutationChance, float mutationStep, Rng& rng) {
+		static_cast<Derived*>(this)->breed(a, b, mutationChance, mutationStep, rng);
+	}
 };
 
 
-template <typename Agent>
+// Generational GA over agents stored by value.
+// The population is double buffered: children are bred straight into the spare buffer, then the buffers swap.
+template <typename A>
 class Evolution {
+	static_assert(std::is_base_of<Agent<A>, A>::value, "Evolution<A> needs A to derive from Agent<A>");
+
 protected:
-	std::vector<std::shared_ptr<Agent>> agents;
+	std::vector<A> agents;
+	std::vector<A> nextAgents;
 	int nAgentsPerGen = 100;
+	float mutationChance = 0;
+	float mutationStep = 0.2f;
+	std::unique_ptr<Selection> selection = std::unique_ptr<Selection>(new RouletteWheel());
+	std::vector<float> fitness;
+	ThreadPool* pool = nullptr;
+	Rng rng = Rng(threadRng().next());
 
-	int getWeightedSelection(float sum) {
-		float chance = 0;
-		float randval = random();
-		for (int i = 0; i < agents.size(); i++) {
-			chance += agents[i]->fitness / sum;
-			if (randval <= chance)
-				return i;
-		}
-	}
-
-	virtual void evaluate(float elapsedTime) {
-
+public:
+	Evolution(int nAgentsPerGen = 100) : nAgentsPerGen(nAgentsPerGen) {
+		agents.reserve(nAgentsPerGen);
 	}
 
-public:
 	void make_next_generation() {
-		float fitnessSum = 0;
+		if (agents.empty())
+			return;
+
+		int m = selection->objectives();
+		fitness.resize(agents.size() * m);
 		for (int i = 0; i < agents.size(); i++) {
-			fitnessSum += agents[i]->fitness;
+			if (m == 1)
+				fitness[i] = agents[i].fitness;
+			else
+				agents[i].objectives(&fitness[i * m], m);
 		}
+		selection->prepare(fitness, nAgentsPerGen * 2, rng);
+
+		// the spare buffer is filled once, after that children overwrite last generation's agents in place
+		if (nextAgents.size() != nAgentsPerGen)
+			nextAgents.resize(nAgentsPerGen, agents[0]);
 
-		std::vector<std::shared_ptr<Agent>> nextGen;
-		for (int i = 0; i < nAgentsPerGen; i++) {
-			int a = getWeightedSelection(fitnessSum);
-			int b = getWeightedSelection(fitnessSum);
-			auto child = agents[a]->intercourse(agents[b]);
-			nextGen.push_back(child);
+		// every child gets its own random stream, so the result only depends on the seed, not on the thread count
+		uint64_t genSeed = rng.next();
+		auto breed = [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				Rng childRng = Rng::stream(genSeed, i);
+				const A& a = agents[selection->select(2 * i, childRng)];
+				const A& b = agents[selection->select(2 * i + 1, childRng)];
+				nextAgents[i].breedFrom(a, b, mutationChance, mutationStep, childRng);
+			}
+		};
+		if (pool)
+			pool->parallelFor(nAgentsPerGen, breed);
+		else
+			breed(0, nAgentsPerGen);
+
+		std::swap(agents, nextAgents);
+		for (A& parent : nextAgents) {
+			parent.shelve();
 		}
+	}
 
-		agents = nextGen;
+	void seed(uint64_t s) {
+		rng.seed(s);
 	}
 
-	virtual void update(float elapsedTime) {
-		evaluate(elapsedTime);
+	void setThreadPool(ThreadPool* p) {
+		pool = p;
 	}
 
-	void addAgent(Agent& agent) {
-		agents.push_back(std::make_shared<Agent>(agent));
+	void setSelection(std::unique_ptr<Selection> s) {
+		selection = std::move(s);
 	}
-};
 
-/*
-class Birb : public Agent {
-	int kk = 10000;
-};
+	void setMutation(float chance, float step) {
+		mutationChance = chance;
+		mutationStep = step;
+	}
+
+	void addAgent(const A& agent) {
+		agents.push_back(agent);
+	}
+
+	std::vector<A>& getAgents() {
+		return agents;
+	}
 
-class EvoDerived : public Evolution {
-	std::vector<Birb> furries;
-	std::shared_ptr<Agent> createAgent() override {
-		return std::make_shared<Birb>();
+	int size() const {
+		return nAgentsPerGen;
 	}
 };
-*/
\ No newline at end of file
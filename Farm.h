@@ -0,0 +1,351 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include "Net.h"
+#include "Serialize.h"
+#include "Config.h"
+#include "Simulation.h"
+#include "Engines.h"
+#include "FitnessCache.h"
+#include "Speciation.h"
+
+// Master/worker fitness evaluation.
+// The master listens on an address; workers (--worker) connect to it whenever they like and are handed
+// batches of genomes plus a course seed, and answer with the fitness, ticks and flaps of every genome.
+// Batches are handed out on demand, so fast workers take more of them. A batch whose worker disconnects or
+// doesn't answer within workTimeout seconds goes back to the queue for someone else.
+//
+// batch:  u8 type (2), u32 round, u32 batch, u64 course seed, f32 max time, u16 count, count genomes (Bird::writeGenome)
+// result: u8 type (3), u32 round, u32 batch, u16 count, then per genome f32 fitness, u32 ticks and u32 flaps
+// noise batch (es engine): u8 type (4), u32 round, u32 batch, u64 course seed, f32 max time, u64 table seed,
+//         u32 table size, f32 sigma, u16 n, n f32 parameters, u16 count, count u32 perturbation codes
+// Workers keep their noise table between batches, so after the first one an es batch costs 4 bytes per bird.
+class EvaluationFarm {
+public:
+	static const uint8_t msgBatch = 2;
+	static const uint8_t msgResult = 3;
+	static const uint8_t msgNoiseBatch = 4;
+
+private:
+	struct Batch {
+		uint32_t round;
+		uint32_t index;
+		int begin;
+		int end;
+	};
+
+	std::string address;
+	int batchSize;
+	int workTimeout;
+
+	Socket listener;
+	std::thread acceptThread;
+	std::vector<std::thread> workerThreads;
+	std::vector<std::shared_ptr<Socket>> workers;
+	std::atomic<bool> running{ false };
+
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::deque<Batch> pending;
+	std::vector<bool> done;
+	int remaining = 0;
+	uint32_t round = 0;
+	std::vector<Bird>* birds = nullptr;
+	const EvolutionStrategy* strategy = nullptr;
+	uint64_t courseSeed = 0;
+	float maxTime = 0;
+
+	void acceptLoop() {
+		while (running) {
+			std::shared_ptr<Socket> worker = std::make_shared<Socket>(listener.accept());
+			if (!worker->valid())
+				continue;
+			worker->setRecvTimeout(workTimeout);
+			worker->setSendTimeout(workTimeout);
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!running)
+				break;
+			workers.push_back(worker);
+			workerThreads.emplace_back(&EvaluationFarm::serveWorker, this, worker);
+			std::cout << "Worker connected (" << workers.size() << " so far)\n";
+		}
+	}
+
+	void serveWorker(std::shared_ptr<Socket> worker) {
+		std::vector<uint8_t> frame;
+		while (true) {
+			Batch batch;
+			ByteWriter out;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				changed.wait(lock, [&] { return !running || !pending.empty(); });
+				if (!running)
+					break;
+				batch = pending.front();
+				pending.pop_front();
+
+				out.u8(strategy ? msgNoiseBatch : msgBatch);
+				out.u32(batch.round);
+				out.u32(batch.index);
+				out.u64(courseSeed);
+				out.f32(maxTime);
+				if (strategy) {
+					out.u64(strategy->noise().seed());
+					out.u32(strategy->noise().size());
+					out.f32(strategy->stepSize());
+					const std::vector<float>& theta = strategy->parameters();
+					out.u16(theta.size());
+					for (float w : theta) {
+						out.f32(w);
+					}
+					out.u16(batch.end - batch.begin);
+					for (int i = batch.begin; i < batch.end; i++) {
+						out.u32(strategy->perturbation(i));
+					}
+				}
+				else {
+					out.u16(batch.end - batch.begin);
+					SeedChain::WriteTable chains;
+					for (int i = batch.begin; i < batch.end; i++) {
+						(*birds)[i].writeGenome(out, chains);
+					}
+				}
+			}
+
+			bool answered = worker->sendFrame(out.bytes) && worker->recvFrame(frame);
+			ByteReader in(frame);
+			if (answered) {
+				answered = in.u8() == msgResult && in.u32() == batch.round && in.u32() == batch.index && in.u16() == batch.end - batch.begin;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!answered) {
+				if (batch.round == round && !done[batch.index])
+					pending.push_front(batch);
+				changed.notify_all();
+				std::cout << "Worker lost, batch " << batch.index << " re-issued\n";
+				break;
+			}
+			if (batch.round == round && !done[batch.index]) {
+				for (int i = batch.begin; i < batch.end; i++) {
+					(*birds)[i].fitness = in.f32();
+					(*birds)[i].ticks = in.u32();
+					(*birds)[i].flaps = in.u32();
+					(*birds)[i].alive = false;
+				}
+				done[batch.index] = true;
+				if (--remaining == 0)
+					changed.notify_all();
+			}
+		}
+		worker->close();
+	}
+
+public:
+	EvaluationFarm(const std::string& address, int batchSize = 50, int workTimeout = 30)
+		: address(address), batchSize(std::max(1, batchSize)), workTimeout(std::max(1, workTimeout)) {}
+
+	~EvaluationFarm() {
+		stop();
+	}
+
+	bool start() {
+		listener = Socket::listen(address);
+		if (!listener.valid()) {
+			std::cout << "Can't listen on " << address << '\n';
+			return false;
+		}
+		running = true;
+		acceptThread = std::thread(&EvaluationFarm::acceptLoop, this);
+		return true;
+	}
+
+	void stop() {
+		if (!running)
+			return;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			running = false;
+		}
+		changed.notify_all();
+		listener.shutdown();
+		listener.close();
+		acceptThread.join();
+		for (auto& w : workers) {
+			w->shutdown();
+		}
+		for (std::thread& t : workerThreads) {
+			t.join();
+		}
+		workers.clear();
+		workerThreads.clear();
+	}
+
+	// Fills in the fitness of every bird by flying it through the course with courseSeed on the workers.
+	// Blocks until every batch has come back. With es, the birds are es's last ask() and only their
+	// perturbation codes are sent.
+	void evaluate(std::vector<Bird>& population, uint64_t seed, float limit, const EvolutionStrategy* es = nullptr) {
+		std::unique_lock<std::mutex> lock(mutex);
+		birds = &population;
+		strategy = es;
+		courseSeed = seed;
+		maxTime = limit;
+		round++;
+		pending.clear();
+		int n = population.size();
+		for (int begin = 0, index = 0; begin < n; begin += batchSize, index++) {
+			pending.push_back({ round, (uint32_t)index, begin, std::min(begin + batchSize, n) });
+		}
+		remaining = pending.size();
+		done.assign(remaining, false);
+		changed.notify_all();
+		changed.wait(lock, [&] { return remaining == 0 || !running; });
+		birds = nullptr;
+		strategy = nullptr;
+	}
+};
+
+// Headless worker: connects to the master at address (retrying while it isn't up) and evaluates batches forever
+void runWorker(const std::string& address, const Config& config, const World& world = World()) {
+	std::vector<Bird> birds;
+	Bird prototype(world.birdX, world.height / 2, config.brainShape);
+	std::vector<uint8_t> frame;
+	std::shared_ptr<const NoiseTable> table;
+	std::vector<float> theta, weights;
+	ThreadPool pool(config.threads);
+	FitnessCache cache(std::max(1, config.fitnessCache));
+
+	while (true) {
+		Socket master = Socket::connect(address);
+		if (!master.valid()) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+			continue;
+		}
+		std::cout << "Connected to " << address << '\n';
+
+		while (master.recvFrame(frame)) {
+			ByteReader in(frame);
+			uint8_t type = in.u8();
+			if (type != EvaluationFarm::msgBatch && type != EvaluationFarm::msgNoiseBatch)
+				continue;
+			uint32_t round = in.u32();
+			uint32_t index = in.u32();
+			uint64_t seed = in.u64();
+			float maxTime = in.f32();
+			int count;
+
+			if (type == EvaluationFarm::msgNoiseBatch) {
+				uint64_t tableSeed = in.u64();
+				int tableSize = in.u32();
+				float sigma = in.f32();
+				theta.resize(in.u16());
+				for (float& w : theta) {
+					w = in.f32();
+				}
+				count = in.u16();
+				if (theta.size() != prototype.getBrain().getWeights().size() || tableSize < theta.size() || tableSize > 1 << 28)
+					in.ok = false;
+				if (in.ok && (!table || table->seed() != tableSeed || table->size() != tableSize))
+					table = NoiseTable::shared(tableSeed, tableSize);
+				birds.resize(count, prototype);
+				for (int i = 0; i < count && in.ok; i++) {
+					uint32_t code = in.u32();
+					if ((code >> 1) > (uint32_t)(tableSize - theta.size()))
+						in.ok = false;
+					else
+						EvolutionStrategy::apply(theta, *table, code, sigma, weights);
+					if (in.ok)
+						birds[i].setWeights(weights);
+				}
+			}
+			else {
+				count = in.u16();
+				birds.resize(count, prototype);
+				SeedChain::ReadTable chains;
+				for (int i = 0; i < count; i++) {
+					if (!birds[i].readGenome(in, config.brainShape, chains))
+						in.ok = false;
+					birds[i].reset();
+				}
+			}
+			if (!in.ok) {
+				std::cout << "Malformed batch (different brainShape?)\n";
+				break;
+			}
+			Config flight = config;
+			flight.maxGenTime = maxTime;
+			if (config.fitnessCache > 0)
+				evaluate(birds, world, seed, flight, cache, &pool);
+			else
+				evaluate(birds, world, seed, flight, &pool);
+
+			ByteWriter out;
+			out.u8(EvaluationFarm::msgResult);
+			out.u32(round);
+			out.u32(index);
+			out.u16(count);
+			for (Bird& b : birds) {
+				out.f32(b.fitness);
+				out.u32(b.ticks);
+				out.u32(b.flaps);
+			}
+			if (!master.sendFrame(out.bytes))
+				break;
+		}
+		std::cout << "Lost master, reconnecting (cache hit rate " << cache.hitRate() * 100 << "%)\n";
+	}
+}
+
+// Master side of the farm: owns selection and breeding (or the config.engine optimizer), leaves every evaluation to the workers
+void runMaster(const Config& config, const World& world = World()) {
+	EvaluationFarm farm(config.farm, config.batchSize, config.workTimeout);
+	if (!farm.start())
+		return;
+	std::cout << "Waiting for workers on " << config.farm << '\n';
+
+	Rng rng(config.seed);
+	Evolution<Bird> evolution(config.population);
+	initEvolution(evolution, config, world, rng);
+	std::vector<Bird>& birds = evolution.getAgents();
+	std::unique_ptr<Optimizer> optimizer = makeOptimizer(config, rng);
+	const EvolutionStrategy* es = dynamic_cast<const EvolutionStrategy*>(optimizer.get());
+	std::vector<std::vector<float>> genomes;
+	std::vector<float> fitness;
+	std::unique_ptr<Speciation> speciation;
+	if (config.speciation)
+		speciation.reset(new Speciation(config.speciesThreshold, config.speciesTarget, rng.next()));
+	if (optimizer)
+		askOptimizer(*optimizer, birds, genomes);
+	else if (!config.checkpoint.empty() && loadGenomes(config.checkpoint, birds, config.brainShape))
+		std::cout << "Resumed from " << config.checkpoint << '\n';
+	for (int gen = 0; gen < config.generations; gen++) {
+		farm.evaluate(birds, config.fixedCourse ? config.seed : rng.next(), config.maxGenTime, es);
+		float best = 0;
+		for (Bird& b : birds) {
+			best = std::max(best, b.fitness);
+		}
+		std::cout << "GENERATION: " << gen << ", SCORE: " << best << "\n";
+		if (config.selfAdaptive)
+			printMutationRates(birds);
+		if (!config.checkpoint.empty() && gen % config.checkpointInterval == config.checkpointInterval - 1)
+			saveGenomes(config.checkpoint, birds);
+		if (optimizer) {
+			tellOptimizer(*optimizer, birds, fitness);
+			askOptimizer(*optimizer, birds, genomes);
+		}
+		else {
+			if (speciation)
+				speciation->share(birds);
+			evolution.make_next_generation();
+		}
+	}
+	farm.stop();
+}
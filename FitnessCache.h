@@ -0,0 +1,138 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Simulation.h"
+#include "ThreadPool.h"
+
+// Fitness of genomes that have already flown a course, keyed by (Bird::genomeHash, course seed), together with
+// what the flight looked like (ticks, flaps, heights), so a cached bird describes and scores like a flown one.
+// Direct-mapped: a new entry simply evicts whatever shared its slot, so lookups and inserts are O(1) and the
+// memory is fixed. Valid for one World and maxTime; not thread-safe (one cache per evaluating thread).
+class FitnessCache {
+public:
+	struct Entry {
+		uint64_t hash;
+		uint64_t seed;
+		float fitness;
+		int ticks;
+		int flaps;
+		float heightSum;
+		float trail[Bird::trailSamples];
+		bool used;
+		bool pending;	// reserved by a bird that is flying right now
+
+		// copies the recorded flight into b
+		void restore(Bird& b) const {
+			b.fitness = fitness;
+			b.ticks = ticks;
+			b.flaps = flaps;
+			b.heightSum = heightSum;
+			std::copy(trail, trail + Bird::trailSamples, b.trail);
+		}
+	};
+
+private:
+	std::vector<Entry> entries;
+	uint64_t mask;
+
+	size_t slot(uint64_t hash, uint64_t seed) const {
+		uint64_t h = (hash ^ (seed * 0xD1B54A32D192ED03ull)) * 0x9E3779B97F4A7C15ull;
+		return (h >> 32) & mask;
+	}
+
+public:
+	long long lookups = 0;
+	long long hits = 0;
+
+	// capacity is rounded up to a power of two
+	FitnessCache(int capacity = 4096) {
+		size_t n = 1;
+		while (n < capacity) {
+			n *= 2;
+		}
+		entries.assign(n, Entry{});
+		mask = n - 1;
+	}
+
+	// the entry for hash on the course with seed (possibly pending), or null
+	const Entry* find(uint64_t hash, uint64_t seed) {
+		lookups++;
+		const Entry& e = entries[slot(hash, seed)];
+		if (!e.used || e.hash != hash || e.seed != seed)
+			return nullptr;
+		hits++;
+		return &e;
+	}
+
+	// marks hash as flying on seed, so later copies in the same batch wait for its result
+	void reserve(uint64_t hash, uint64_t seed) {
+		Entry& e = entries[slot(hash, seed)];
+		e = Entry{};
+		e.hash = hash;
+		e.seed = seed;
+		e.used = true;
+		e.pending = true;
+	}
+
+	void insert(uint64_t hash, uint64_t seed, const Bird& b) {
+		Entry& e = entries[slot(hash, seed)];
+		e = { hash, seed, b.fitness, b.ticks, b.flaps, b.heightSum, {}, true, false };
+		std::copy(b.trail, b.trail + Bird::trailSamples, e.trail);
+	}
+
+	void erase(uint64_t hash, uint64_t seed) {
+		Entry& e = entries[slot(hash, seed)];
+		if (e.used && e.hash == hash && e.seed == seed)
+			e.used = false;
+	}
+
+	float hitRate() const {
+		return lookups ? (float)hits / lookups : 0;
+	}
+};
+
+// evaluate() that only flies genomes the cache hasn't seen on this course. Cached birds and copies of a
+// genome already flying this generation are marked dead up front and get the recorded flight without flying.
+// Birds cut by racing are not cached: their score depends on who else flew that generation.
+float evaluate(std::vector<Bird>& birds, const World& world, uint64_t seed, const Config& config, FitnessCache& cache, ThreadPool* pool = nullptr) {
+	int n = birds.size();
+	std::vector<uint64_t> hashes(n);
+	std::vector<int> copyOf(n, -1);
+	std::vector<bool> flying(n, false);
+	float best = 0;
+	for (int i = 0; i < n; i++) {
+		if (!birds[i].alive)
+			continue;
+		hashes[i] = birds[i].genomeHash();
+		if (const FitnessCache::Entry* e = cache.find(hashes[i], seed)) {
+			if (!e->pending) {
+				e->restore(birds[i]);
+				birds[i].alive = false;
+				best = std::max(best, birds[i].fitness);
+				continue;
+			}
+			for (int j = i - 1; j >= 0 && copyOf[i] == -1; j--) {
+				if (flying[j] && hashes[j] == hashes[i])
+					copyOf[i] = j;
+			}
+			if (copyOf[i] >= 0) {
+				birds[i].alive = false;
+				continue;
+			}
+		}
+		flying[i] = true;
+		cache.reserve(hashes[i], seed);
+	}
+
+	float time = evaluate(birds, world, seed, config, pool);
+
+	for (int i = 0; i < n; i++) {
+		if (flying[i] && birds[i].cut)
+			cache.erase(hashes[i], seed);
+		else if (flying[i])
+			cache.insert(hashes[i], seed, birds[i]);
+		else if (copyOf[i] >= 0)
+			birds[i].copyFlight(birds[copyOf[i]]);
+	}
+	return std::max(time, best);
+}
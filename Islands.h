@@ -0,0 +1,228 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <numeric>
+#include <iostream>
+#include "Config.h"
+#include "Evolution.h"
+#include "Simulation.h"
+#include "ThreadPool.h"
+#include "MigrationQueue.h"
+#include "Distributed.h"
+#include "FitnessCache.h"
+#include "Surrogate.h"
+#include "Novelty.h"
+#include "Speciation.h"
+
+// Island model: several independent populations, each evolved by its own thread.
+// Every migrationInterval generations an island sends copies of its best migrationCount birds to its
+// neighbours (ring: next island, full: every island, random: one random island) and takes in whatever
+// arrived in its inbox in place of its worst birds. Islands never wait for each other.
+// Islands run the genetic algorithm only: the weight-vector engines keep their own model of the population
+// and can't take in migrants, so any other config.engine refuses to start (ok is false).
+class IslandModel {
+	struct Island {
+		Evolution<Bird> evolution;
+		MigrationQueue<Bird> inbox;
+		Rng rng;
+		std::unique_ptr<FitnessCache> cache;
+		std::unique_ptr<Surrogate> surrogate;
+		std::unique_ptr<NoveltySearch> novelty;
+		std::unique_ptr<Speciation> speciation;
+		std::atomic<int> generation{ 0 };
+		std::atomic<float> best{ 0 };
+		std::atomic<float> accuracy{ 0 };
+		std::atomic<float> chance{ 0 };	// population means of the self-adapted mutation rates
+		std::atomic<float> step{ 0 };
+
+		Island(int population, size_t inboxSize, const Bird& prototype) : evolution(population), inbox(inboxSize, prototype) {}
+	};
+
+	Config config;
+	World world;
+	std::vector<std::unique_ptr<Island>> islands;
+	PeerNetwork* network = nullptr;
+
+	void emigrate(int from, std::vector<Bird>& birds) {
+		int n = islands.size();
+		int k = std::min(config.migrationCount, (int)birds.size());
+		std::vector<int> order(birds.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::partial_sort(order.begin(), order.begin() + k, order.end(), [&](int a, int b) { return birds[a].fitness > birds[b].fitness; });
+
+		std::vector<int> targets;
+		if (n > 1) {
+			if (config.topology == "full") {
+				for (int to = 0; to < n; to++) {
+					if (to != from)
+						targets.push_back(to);
+				}
+			}
+			else if (config.topology == "random") {
+				int to = islands[from]->rng.range(0, n - 2);
+				targets.push_back(to >= from ? to + 1 : to);
+			}
+			else {
+				targets.push_back((from + 1) % n);
+			}
+		}
+
+		for (int to : targets) {
+			for (int i = 0; i < k; i++) {
+				islands[to]->inbox.push(birds[order[i]]);
+			}
+		}
+
+		// island 0 is also this process' gateway to the other processes
+		if (network && from == 0) {
+			std::vector<const Bird*> migrants;
+			for (int i = 0; i < k; i++) {
+				migrants.push_back(&birds[order[i]]);
+			}
+			for (int peer : network->targets(config.topology, islands[from]->rng)) {
+				network->send(peer, migrants);
+			}
+		}
+	}
+
+	void immigrate(Island& island, std::vector<Bird>& birds) {
+		std::vector<int> order(birds.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](int a, int b) { return birds[a].fitness < birds[b].fitness; });
+		for (int i = 0; i < order.size() && island.inbox.pop(birds[order[i]]); i++);
+	}
+
+	void run(int id) {
+		pinToCore(id);
+		Island& island = *islands[id];
+		std::vector<Bird>& birds = island.evolution.getAgents();
+		for (int gen = 0; gen < config.generations; gen++) {
+			uint64_t courseSeed = config.fixedCourse ? config.seed : island.rng.next();
+			if (island.surrogate)
+				island.surrogate->screen(birds, config.surrogateKeep);
+			float score = island.cache ? evaluate(birds, world, courseSeed, config, *island.cache) : evaluate(birds, world, courseSeed, config);
+			if (score > island.best)
+				island.best = score;
+			if (island.surrogate) {
+				island.surrogate->learn(birds);
+				island.accuracy = island.surrogate->accuracy;
+			}
+			if (island.novelty)
+				island.novelty->score(birds);
+
+			if ((islands.size() > 1 || network) && gen % config.migrationInterval == config.migrationInterval - 1) {
+				emigrate(id, birds);
+				immigrate(island, birds);
+			}
+
+			if (island.speciation)
+				island.speciation->share(birds);
+			island.evolution.make_next_generation();
+			if (config.selfAdaptive) {
+				float chance = 0, step = 0;
+				for (const Bird& b : birds) {
+					chance += b.mutationChance();
+					step += b.mutationStep();
+				}
+				island.chance = chance / birds.size();
+				island.step = step / birds.size();
+			}
+			island.generation = gen + 1;
+		}
+	}
+
+public:
+	bool ok = true;
+
+	IslandModel(const Config& config, const World& world = World()) : config(config), world(world) {
+		if (config.engine != "ga") {
+			std::cout << "engine = " << config.engine << " can't run on islands (--islands needs engine = ga)\n";
+			ok = false;
+			return;
+		}
+		this->config.islands = std::max(1, config.islands);
+		this->config.migrationInterval = std::max(1, config.migrationInterval);
+		int n = this->config.islands;
+		Rng seeder(config.seed);
+		Bird prototype(world.birdX, world.height / 2, config.brainShape, seeder);
+		size_t inboxSize = std::max(2, config.migrationCount * (n - 1 + (int)config.nodes.size()) * 2);
+		for (int i = 0; i < n; i++) {
+			islands.emplace_back(new Island(config.population, inboxSize, prototype));
+			Island& island = *islands[i];
+			island.rng = Rng::stream(config.seed, i);
+			initEvolution(island.evolution, config, world, island.rng);
+			if (config.fitnessCache > 0)
+				island.cache.reset(new FitnessCache(config.fitnessCache));
+			if (config.surrogate)
+				island.surrogate.reset(new Surrogate(config.brainShape[0], 2 * config.population, island.rng.next()));
+			if (config.novelty)
+				island.novelty.reset(new NoveltySearch(config.noveltyK, config.noveltyArchive));
+			if (config.speciation)
+				island.speciation.reset(new Speciation(config.speciesThreshold, config.speciesTarget, island.rng.next()));
+		}
+	}
+
+	// migrants from other processes; network receives into island 0's inbox
+	void setNetwork(PeerNetwork* n) {
+		network = n;
+	}
+
+	MigrationQueue<Bird>& inbox(int island) {
+		return islands[island]->inbox;
+	}
+
+	// evolves every island on its own thread, printing progress once a second, until all are done
+	void start() {
+		std::vector<std::thread> threads;
+		for (int i = 0; i < islands.size(); i++) {
+			threads.emplace_back(&IslandModel::run, this, i);
+		}
+
+		while (true) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+			int slowest = config.generations;
+			float best = 0;
+			for (auto& island : islands) {
+				slowest = std::min(slowest, island->generation.load());
+				best = std::max(best, island->best.load());
+			}
+			std::cout << "GENERATION: " << slowest << ", SCORE: " << best << "\n";
+			if (config.surrogate) {
+				float accuracy = 0;
+				for (auto& island : islands) {
+					accuracy += island->accuracy;
+				}
+				std::cout << "SURROGATE ACCURACY: " << accuracy / islands.size() << "\n";
+			}
+			if (config.selfAdaptive) {
+				float chance = 0, step = 0;
+				for (auto& island : islands) {
+					chance += island->chance;
+					step += island->step;
+				}
+				std::cout << "MUTATION CHANCE: " << chance / islands.size() << ", STEP: " << step / islands.size() << "\n";
+			}
+			if (slowest >= config.generations)
+				break;
+		}
+
+		for (std::thread& t : threads) {
+			t.join();
+		}
+	}
+
+	// share of evaluations answered by the islands' fitness caches
+	float cacheHitRate() const {
+		long long lookups = 0, hits = 0;
+		for (auto& island : islands) {
+			if (island->cache) {
+				lookups += island->cache->lookups;
+				hits += island->cache->hits;
+			}
+		}
+		return lookups ? (float)hits / lookups : 0;
+	}
+};
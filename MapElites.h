@@ -0,0 +1,191 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "Config.h"
+#include "Simulation.h"
+#include "ThreadPool.h"
+#include "MappedFile.h"
+
+// MAP-Elites: instead of one population, keep the best bird found for every cell of a resolution x resolution
+// grid over behaviour (mean height x share of ticks with a flap). Each batch mutates random elites, flies the
+// mutants and lets every mutant take its cell if the cell is empty or its elite did worse.
+//
+// The grid is one flat block of fixed-size records, so a cell is found by index arithmetic. With a path it
+// lives in a memory-mapped file and is kept (and resumed from) between runs. A non-empty file that isn't a grid
+// of this resolution and brain shape is left untouched and the map refuses to start (ok is false).
+// header: u32 magic, u32 resolution, u32 weights per genome, u32 unused
+// cell:   f32 fitness, f32 mean height, f32 flap share, u32 occupied, then the weights as f32 (native byte order)
+class MapElites {
+	struct Cell {
+		float fitness;
+		float height;
+		float flapping;
+		uint32_t used;
+	};
+
+	static const uint32_t magic = 0x4C45504D;	// "MPEL"
+	static const int headerSize = 16;
+
+	int resolution;
+	int weightCount;
+	size_t cellSize;
+	MappedFile file;
+	std::vector<uint8_t> memory;
+	uint8_t* grid = nullptr;
+	std::vector<int> occupied;
+	Config config;
+	Rng rng;
+	ThreadPool* pool = nullptr;
+
+	uint8_t* cell(int index) {
+		return grid + headerSize + index * cellSize;
+	}
+
+	Cell read(int index) {
+		Cell c;
+		std::memcpy(&c, cell(index), sizeof(c));
+		return c;
+	}
+
+	const float* weightsOf(int index) {
+		return (const float*)(cell(index) + sizeof(Cell));
+	}
+
+	void format() {
+		std::memset(grid, 0, headerSize + (size_t)resolution * resolution * cellSize);
+		uint32_t header[4] = { magic, (uint32_t)resolution, (uint32_t)weightCount, 0 };
+		std::memcpy(grid, header, sizeof(header));
+	}
+
+public:
+	float best = 0;
+	bool ok = true;
+
+	MapElites(const Config& config, const std::string& path, uint64_t seed)
+		: resolution(std::max(1, config.mapResolution)), config(config), rng(seed) {
+		weightCount = NeuralNetwork(config.brainShape, false).getWeights().size();
+		cellSize = sizeof(Cell) + 4 * (size_t)weightCount;
+		size_t bytes = headerSize + (size_t)resolution * resolution * cellSize;
+		if (!path.empty() && !compatible(path)) {
+			std::cout << path << " is not a " << resolution << "x" << resolution << " grid of " << weightCount
+				<< "-weight brains (check mapResolution and brainShape, or use a new mapFile)\n";
+			ok = false;
+			return;
+		}
+		if (!path.empty() && file.open(path, bytes)) {
+			grid = file.data();
+		}
+		else {
+			memory.resize(bytes);
+			grid = memory.data();
+		}
+
+		uint32_t header[4];
+		std::memcpy(header, grid, sizeof(header));
+		if (header[0] != magic || header[1] != resolution || header[2] != weightCount) {
+			format();
+			return;
+		}
+		for (int i = 0; i < resolution * resolution; i++) {
+			Cell c = read(i);
+			if (c.used) {
+				occupied.push_back(i);
+				best = std::max(best, c.fitness);
+			}
+		}
+		std::cout << "Resumed " << occupied.size() << " elites from " << path << '\n';
+	}
+
+	// true when path is missing, empty, or holds a grid with this resolution and weight count
+	bool compatible(const std::string& path) const {
+		std::ifstream in(path, std::ios::binary | std::ios::ate);
+		if (!in || in.tellg() == 0)
+			return true;
+		uint32_t header[4] = {};
+		in.seekg(0);
+		in.read((char*)header, sizeof(header));
+		return in && header[0] == magic && header[1] == resolution && header[2] == weightCount;
+	}
+
+	void setThreadPool(ThreadPool* p) {
+		pool = p;
+	}
+
+	// cell of a bird that has flown
+	int cellOf(const Bird& b) const {
+		float height = b.ticks ? b.heightSum / b.ticks : 0.5f;
+		float flapping = b.ticks ? (float)b.flaps / b.ticks : 0;
+		int x = std::min((int)(height * resolution), resolution - 1);
+		int y = std::min((int)(flapping * resolution), resolution - 1);
+		return y * resolution + x;
+	}
+
+	// Fills birds with the next batch: mutants of random elites, or random brains while the grid is empty
+	void ask(std::vector<Bird>& birds) {
+		uint64_t genSeed = rng.next();
+		auto make = [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				Rng childRng = Rng::stream(genSeed, i);
+				if (occupied.empty()) {
+					birds[i].getBrain().randomize(childRng);
+					birds[i].reset();
+					continue;
+				}
+				int parent = occupied[childRng.range(0, occupied.size() - 1)];
+				birds[i].setWeights(weightsOf(parent));
+				birds[i].getBrain().mutate(config.mutationChance, config.mutationStep, childRng);
+			}
+		};
+		if (pool)
+			pool->parallelFor(birds.size(), make);
+		else
+			make(0, birds.size());
+	}
+
+	// Offers every bird of a flown batch to its cell
+	void tell(const std::vector<Bird>& birds) {
+		for (const Bird& b : birds) {
+			if (b.ticks == 0)
+				continue;
+			int index = cellOf(b);
+			Cell c = read(index);
+			if (c.used && c.fitness >= b.fitness)
+				continue;
+			if (!c.used)
+				occupied.push_back(index);
+			c = { b.fitness, b.heightSum / b.ticks, (float)b.flaps / b.ticks, 1 };
+			std::memcpy(cell(index), &c, sizeof(c));
+			std::memcpy(cell(index) + sizeof(Cell), b.getBrain().getWeights().data(), 4 * (size_t)weightCount);
+			best = std::max(best, b.fitness);
+		}
+	}
+
+	int filled() const {
+		return occupied.size();
+	}
+
+	void flush() {
+		file.flush();
+	}
+};
+
+// Headless MAP-Elites (--map): batches of config.population mutants flown in parallel, config.generations times
+void runMapElites(const Config& config, const World& world = World()) {
+	Rng rng(config.seed);
+	ThreadPool pool(config.threads);
+	MapElites map(config, config.mapFile, rng.next());
+	if (!map.ok)
+		return;
+	map.setThreadPool(&pool);
+	std::vector<Bird> birds(config.population, Bird(world.birdX, world.height / 2, config.brainShape, rng));
+	for (int gen = 0; gen < config.generations; gen++) {
+		map.ask(birds);
+		simulate(birds, world, config.fixedCourse ? config.seed : rng.next(), config.maxGenTime, pool);
+		map.tell(birds);
+		std::cout << "GENERATION: " << gen << ", SCORE: " << map.best << ", CELLS: " << map.filled() << "\n";
+	}
+	map.flush();
+}
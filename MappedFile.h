@@ -0,0 +1,108 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <iostream>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// A file mapped read/write into memory, grown to at least the requested size (new bytes are zero).
+// Writes through data() reach the file without any explicit save; flush() forces them to disk.
+class MappedFile {
+	uint8_t* bytes = nullptr;
+	size_t length = 0;
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+
+public:
+	MappedFile() {}
+	~MappedFile() {
+		close();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path, size_t size) {
+		close();
+#if defined(_WIN32)
+		file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER current;
+		GetFileSizeEx(file, &current);
+		if ((size_t)current.QuadPart > size)
+			size = current.QuadPart;
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+		if (mapping)
+			bytes = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) == 0 && (size_t)st.st_size > size)
+			size = st.st_size;
+		if (ftruncate(fd, size) == 0) {
+			void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (p != MAP_FAILED)
+				bytes = (uint8_t*)p;
+		}
+#endif
+		if (!bytes) {
+			std::cout << "Can't map " << path << '\n';
+			close();
+			return false;
+		}
+		length = size;
+		return true;
+	}
+
+	void flush() {
+		if (!bytes)
+			return;
+#if defined(_WIN32)
+		FlushViewOfFile(bytes, length);
+#else
+		msync(bytes, length, MS_SYNC);
+#endif
+	}
+
+	void close() {
+#if defined(_WIN32)
+		if (bytes)
+			UnmapViewOfFile(bytes);
+		if (mapping)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (bytes)
+			munmap(bytes, length);
+		if (fd >= 0)
+			::close(fd);
+		fd = -1;
+#endif
+		bytes = nullptr;
+		length = 0;
+	}
+
+	uint8_t* data() {
+		return bytes;
+	}
+
+	size_t size() const {
+		return length;
+	}
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov).
+// Slots are preallocated copies of a prototype, so pushing a migrant reuses the slot's storage.
+template <typename T>
+class MigrationQueue {
+	std::vector<T> slots;
+	std::unique_ptr<std::atomic<size_t>[]> sequence;
+	size_t mask;
+	std::atomic<size_t> enqueuePos{ 0 };
+	std::atomic<size_t> dequeuePos{ 0 };
+
+public:
+	// capacity is rounded up to a power of two
+	MigrationQueue(size_t capacity, const T& prototype) {
+		size_t size = 2;
+		while (size < capacity) {
+			size *= 2;
+		}
+		mask = size - 1;
+		slots.resize(size, prototype);
+		sequence.reset(new std::atomic<size_t>[size]);
+		for (size_t i = 0; i < size; i++) {
+			sequence[i].store(i, std::memory_order_relaxed);
+		}
+	}
+
+	// returns false (and drops the item) when the queue is full
+	bool push(const T& item) {
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		while (true) {
+			size_t seq = sequence[pos & mask].load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0) {
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0) {
+				return false;
+			}
+			else {
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		slots[pos & mask] = item;
+		sequence[pos & mask].store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& out) {
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		while (true) {
+			size_t seq = sequence[pos & mask].load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0) {
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0) {
+				return false;
+			}
+			else {
+				pos = dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+		out = slots[pos & mask];
+		sequence[pos & mask].store(pos + mask + 1, std::memory_order_release);
+		return true;
+	}
+};
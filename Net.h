@@ -0,0 +1,283 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
+
+// Blocking stream socket with length-prefixed framing.
+// Addresses are "host:port" for TCP or "unix:/path" for a Unix domain socket (not on Windows).
+class Socket {
+#if defined(_WIN32)
+	typedef SOCKET Handle;
+	static Handle invalid() { return INVALID_SOCKET; }
+#else
+	typedef int Handle;
+	static Handle invalid() { return -1; }
+#endif
+
+	Handle handle = invalid();
+
+	explicit Socket(Handle h) : handle(h) {}
+
+	static bool startup() {
+#if defined(_WIN32)
+		static bool started = false;
+		if (!started) {
+			WSADATA data;
+			started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+		}
+		return started;
+#else
+		return true;
+#endif
+	}
+
+	static bool isUnix(const std::string& address) {
+		return address.compare(0, 5, "unix:") == 0;
+	}
+
+	static bool splitHostPort(const std::string& address, std::string& host, std::string& port) {
+		size_t colon = address.rfind(':');
+		if (colon == std::string::npos)
+			return false;
+		host = address.substr(0, colon);
+		port = address.substr(colon + 1);
+		if (host.empty() || host == "*")
+			host = "0.0.0.0";
+		return true;
+	}
+
+	bool sendAll(const uint8_t* data, size_t n) {
+		while (n > 0) {
+#if defined(_WIN32)
+			int sent = ::send(handle, (const char*)data, (int)n, 0);
+#else
+			ssize_t sent = ::send(handle, data, n, MSG_NOSIGNAL);
+#endif
+			if (sent <= 0)
+				return false;
+			data += sent;
+			n -= sent;
+		}
+		return true;
+	}
+
+	bool recvAll(uint8_t* data, size_t n) {
+		while (n > 0) {
+#if defined(_WIN32)
+			int got = ::recv(handle, (char*)data, (int)n, 0);
+#else
+			ssize_t got = ::recv(handle, data, n, 0);
+#endif
+			if (got <= 0)
+				return false;
+			data += got;
+			n -= got;
+		}
+		return true;
+	}
+
+public:
+	// frames bigger than this are treated as a broken peer
+	static const uint32_t maxFrame = 64 * 1024 * 1024;
+
+	Socket() {}
+	~Socket() {
+		close();
+	}
+
+	Socket(Socket&& other) : handle(other.handle) {
+		other.handle = invalid();
+	}
+
+	Socket& operator=(Socket&& other) {
+		if (this != &other) {
+			close();
+			handle = other.handle;
+			other.handle = invalid();
+		}
+		return *this;
+	}
+
+	Socket(const Socket&) = delete;
+	Socket& operator=(const Socket&) = delete;
+
+	bool valid() const {
+		return handle != invalid();
+	}
+
+	void close() {
+		if (!valid())
+			return;
+#if defined(_WIN32)
+		::closesocket(handle);
+#else
+		::close(handle);
+#endif
+		handle = invalid();
+	}
+
+	// wakes up a thread blocked in accept/recv on this socket
+	void shutdown() {
+		if (!valid())
+			return;
+#if defined(_WIN32)
+		::shutdown(handle, SD_BOTH);
+#else
+		::shutdown(handle, SHUT_RDWR);
+#endif
+	}
+
+	// gives up on sends that stall for longer than seconds (a hung peer must not stall the caller)
+	void setSendTimeout(int seconds) {
+#if defined(_WIN32)
+		DWORD ms = seconds * 1000;
+		setsockopt(handle, SOL_SOCKET, SO_SNDTIMEO, (const char*)&ms, sizeof(ms));
+#else
+		timeval tv = { seconds, 0 };
+		setsockopt(handle, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+#endif
+	}
+
+	// recv fails instead of waiting longer than seconds (lets a caller notice a hung peer)
+	void setRecvTimeout(int seconds) {
+#if defined(_WIN32)
+		DWORD ms = seconds * 1000;
+		setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, (const char*)&ms, sizeof(ms));
+#else
+		timeval tv = { seconds, 0 };
+		setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+#endif
+	}
+
+	static Socket listen(const std::string& address) {
+		if (!startup())
+			return Socket();
+
+		if (isUnix(address)) {
+#if defined(_WIN32)
+			std::cout << "Unix domain sockets are not supported here: " << address << '\n';
+			return Socket();
+#else
+			std::string path = address.substr(5);
+			Socket s(::socket(AF_UNIX, SOCK_STREAM, 0));
+			if (!s.valid())
+				return s;
+			sockaddr_un addr = {};
+			addr.sun_family = AF_UNIX;
+			std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+			::unlink(path.c_str());
+			if (::bind(s.handle, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(s.handle, 16) != 0)
+				s.close();
+			return s;
+#endif
+		}
+
+		std::string host, port;
+		if (!splitHostPort(address, host, port))
+			return Socket();
+		addrinfo hints = {};
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_PASSIVE;
+		addrinfo* info = nullptr;
+		if (getaddrinfo(host.c_str(), port.c_str(), &hints, &info) != 0)
+			return Socket();
+
+		Socket s(::socket(info->ai_family, info->ai_socktype, info->ai_protocol));
+		if (s.valid()) {
+			int yes = 1;
+			setsockopt(s.handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&yes, sizeof(yes));
+			if (::bind(s.handle, info->ai_addr, (int)info->ai_addrlen) != 0 || ::listen(s.handle, 16) != 0)
+				s.close();
+		}
+		freeaddrinfo(info);
+		return s;
+	}
+
+	static Socket connect(const std::string& address) {
+		if (!startup())
+			return Socket();
+
+		if (isUnix(address)) {
+#if defined(_WIN32)
+			return Socket();
+#else
+			Socket s(::socket(AF_UNIX, SOCK_STREAM, 0));
+			if (!s.valid())
+				return s;
+			sockaddr_un addr = {};
+			addr.sun_family = AF_UNIX;
+			std::strncpy(addr.sun_path, address.substr(5).c_str(), sizeof(addr.sun_path) - 1);
+			if (::connect(s.handle, (sockaddr*)&addr, sizeof(addr)) != 0)
+				s.close();
+			return s;
+#endif
+		}
+
+		std::string host, port;
+		if (!splitHostPort(address, host, port))
+			return Socket();
+		addrinfo hints = {};
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		addrinfo* info = nullptr;
+		if (getaddrinfo(host.c_str(), port.c_str(), &hints, &info) != 0)
+			return Socket();
+
+		Socket s(::socket(info->ai_family, info->ai_socktype, info->ai_protocol));
+		if (s.valid()) {
+			if (::connect(s.handle, info->ai_addr, (int)info->ai_addrlen) != 0) {
+				s.close();
+			}
+			else {
+				int yes = 1;
+				setsockopt(s.handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&yes, sizeof(yes));
+			}
+		}
+		freeaddrinfo(info);
+		return s;
+	}
+
+	Socket accept() {
+		Socket s(::accept(handle, nullptr, nullptr));
+		if (s.valid()) {
+			// harmlessly fails on Unix domain sockets
+			int yes = 1;
+			setsockopt(s.handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&yes, sizeof(yes));
+		}
+		return s;
+	}
+
+	// frame: u32 little-endian payload length, then the payload
+	bool sendFrame(const std::vector<uint8_t>& payload) {
+		uint32_t n = payload.size();
+		uint8_t header[4] = { (uint8_t)n, (uint8_t)(n >> 8), (uint8_t)(n >> 16), (uint8_t)(n >> 24) };
+		return sendAll(header, 4) && sendAll(payload.data(), payload.size());
+	}
+
+	bool recvFrame(std::vector<uint8_t>& payload) {
+		uint8_t header[4];
+		if (!recvAll(header, 4))
+			return false;
+		uint32_t n = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+		if (n > maxFrame)
+			return false;
+		payload.resize(n);
+		return recvAll(payload.data(), n);
+	}
+};
@@ -0,0 +1,232 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include "olcPixelGameEngine.h"
+#include "Random.h"
+#include "Serialize.h"
+
+float sigmoid(float x) {
+	return 1 / (1 + exp(-x));
+}
+
+class NeuralNetwork {
+	// Dense Neural Network
+	// weights are stored flat, layer by layer: weight (layer, a, b) is at offsets[layer] + a * shape[layer + 1] + b
+	std::vector<float> weights;
+	std::vector<int> offsets;
+	std::vector<int> shape;
+	std::vector<std::vector<float>> values;
+
+	float& weight(int layer, int a, int b) {
+		return weights[offsets[layer] + a * shape[layer + 1] + b];
+	}
+
+public:
+	NeuralNetwork(const std::vector<int>& shape, bool randomize = true, Rng& rng = threadRng()) : shape(shape) {
+		int size = 0;
+		for (int i = 0; i < shape.size()-1; i++) {
+			offsets.push_back(size);
+			size += shape[i] * shape[i + 1];
+		}
+		weights.resize(size);
+		if (randomize)
+			this->randomize(rng);
+
+		for (int i = 0; i < shape.size(); i++) {
+			values.push_back(std::vector<float>());
+			for (int j = 0; j < shape[i]; j++) {
+				values[i].push_back(0.0f);
+			}
+		}
+	}
+
+	std::vector<float>& evaluate(std::vector<float>& input) {
+		for (int i = 0; i < shape[0]; i++) {
+			values[0][i] = input[i];
+		}
+
+		for (int layer = 1; layer < shape.size(); layer++) {
+			const float* w = &weights[offsets[layer - 1]];
+			for (int b = 0; b < shape[layer]; b++) {
+				double sum = 0;
+				for (int a = 0; a < shape[layer - 1]; a++) {
+					sum += values[layer - 1][a] * w[a * shape[layer] + b];
+				}
+				values[layer][b] = sigmoid(sum);
+			}
+		}
+
+		return values[shape.size() - 1];
+	}
+
+	// Mutates each weight with probability chance.
+	// Mutated positions are found by geometric skip-ahead, so the cost is one draw per mutation, not per weight.
+	void mutate(float chance, float lr = 0.2f, Rng& rng = threadRng()) {
+		int n = weights.size();
+		for (int i = rng.geometric(chance); i < n; ) {
+			weights[i] += rng.uniform2() * lr;
+			int skip = rng.geometric(chance);
+			if (skip >= n - i)
+				break;
+			i += skip + 1;
+		}
+	}
+
+	// Fused crossover + mutation: writes the child of a and b into child in a single pass.
+	// Uniform crossover takes one 64 bit draw per 64 weights.
+	static void breed(const NeuralNetwork& a, const NeuralNetwork& b, NeuralNetwork& child, float chance, float lr, Rng& rng = threadRng()) {
+		int n = a.weights.size();
+		child.weights.resize(n);
+		const float* wa = a.weights.data();
+		const float* wb = b.weights.data();
+		float* wc = child.weights.data();
+		for (int base = 0; base < n; base += 64) {
+			uint64_t mask = rng.next();
+			int end = std::min(base + 64, n);
+			for (int i = base; i < end; i++, mask >>= 1) {
+				wc[i] = (mask & 1) ? wa[i] : wb[i];
+			}
+		}
+		child.mutate(chance, lr, rng);
+	}
+
+	NeuralNetwork intercourse(const NeuralNetwork& partner, float chance = 0, float lr = 0.2f) const {
+		NeuralNetwork child(shape, false);
+		breed(*this, partner, child, chance, lr);
+		return child;
+	}
+
+	const std::vector<int>& getShape() const {
+		return shape;
+	}
+
+	const std::vector<float>& getWeights() const {
+		return weights;
+	}
+
+	// number of weights the shape has, whether or not they are allocated
+	int weightCount() const {
+		return offsets.empty() ? 0 : offsets.back() + shape[shape.size() - 2] * shape.back();
+	}
+
+	// frees the weights (a genome that can regenerate them keeps only the shape); allocate() brings them back
+	void release() {
+		std::vector<float>().swap(weights);
+	}
+
+	void allocate() {
+		weights.resize(weightCount());
+	}
+
+	// 64-bit content hash of the weights (two weights per multiply-xorshift round)
+	uint64_t hash() const {
+		uint64_t h = 0x243F6A8885A308D3ull ^ weights.size();
+		int n = weights.size();
+		for (int i = 0; i < n; i += 2) {
+			uint32_t lo, hi = 0;
+			std::memcpy(&lo, &weights[i], 4);
+			if (i + 1 < n)
+				std::memcpy(&hi, &weights[i + 1], 4);
+			h = (h ^ ((uint64_t)hi << 32 | lo)) * 0x9E3779B97F4A7C15ull;
+			h ^= h >> 29;
+		}
+		h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+		return h ^ (h >> 31);
+	}
+
+	// w must hold exactly as many weights as getWeights()
+	void setWeights(const float* w) {
+		std::copy(w, w + weights.size(), weights.begin());
+	}
+
+	void setWeights(const std::vector<float>& w) {
+		setWeights(w.data());
+	}
+
+	void randomize(Rng& rng) {
+		for (float& w : weights) {
+			w = rng.uniform2();
+		}
+	}
+
+	// adds strength * N(0,1) noise drawn from a generator seeded with seed to every weight
+	void perturb(uint64_t seed, float strength) {
+		Rng rng(seed);
+		for (float& w : weights) {
+			w += strength * rng.normal();
+		}
+	}
+
+	// binary form: u16 layer count, u16 per layer size, then every weight as f32
+	void write(ByteWriter& out) const {
+		out.u16(shape.size());
+		for (int s : shape) {
+			out.u16(s);
+		}
+		for (float w : weights) {
+			out.f32(w);
+		}
+	}
+
+	// returns false on a malformed buffer or when the shape differs from expectedShape
+	static bool read(ByteReader& in, const std::vector<int>& expectedShape, NeuralNetwork& out) {
+		int layers = in.u16();
+		if (!in.ok || layers != expectedShape.size())
+			return false;
+		for (int i = 0; i < layers; i++) {
+			if (in.u16() != expectedShape[i])
+				return false;
+		}
+		if (out.shape != expectedShape)
+			out = NeuralNetwork(expectedShape, false);
+		for (float& w : out.weights) {
+			w = in.f32();
+		}
+		return in.ok;
+	}
+
+	void draw(olc::PixelGameEngine* canvas, int x, int y) {
+		const int nodeR = 10;
+		const int layerGap = 60;
+		const int nodeGap = 40;
+		
+		int biggest = 0;
+		for (int s : shape) {
+			biggest = std::max(biggest, s);
+		}
+
+		int maxHeight = biggest * nodeR * 2 + (biggest - 1) * nodeGap;
+		std::vector<olc::vi2d> positions;
+
+		int sx = x;
+		for (int layer = 0; layer < shape.size(); layer++) {
+			int height = shape[layer] * nodeR * 2 + (shape[layer] - 1) * nodeGap;
+			int sy = y + (maxHeight - height) / 2;
+			for (int n = 0; n < shape[layer]; n++) {
+				canvas->FillCircle({ sx + nodeR, sy + nodeR }, nodeR, olc::GREY);
+				positions.push_back(olc::vi2d(sx + nodeR, sy + nodeR));
+				sy += nodeR * 2 + nodeGap;
+			}
+
+			sx += nodeR * 2 + layerGap;
+		}
+
+		int c = 0;
+		for (int layer = 0; layer < shape.size()-1; layer++) {
+			for (int n = 0; n < shape[layer]; n++) {
+				for (int n2 = 0; n2 < shape[layer + 1]; n2++) {
+					auto& positionA = positions[c + n];
+					auto& positionB = positions[c + shape[layer] + n2];
+					float w = weight(layer, n, n2);
+					float shade = (w + 1) / 2 * 255;
+					olc::Pixel color(shade,shade,shade);
+					//std::cout << weight << ' ' << (weight + 1) / 2 * 255 <<' '<< (int)color.g << '\n';
+					canvas->DrawLine(positionA, positionB, color);
+				}
+			}
+			c += shape[layer];
+		}
+	}
+};
@@ -0,0 +1,227 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include "Simulation.h"
+#include "ThreadPool.h"
+
+// k-d tree over points of dims floats, built around medians in one pass (assign) or grown by insertion.
+// An inserted point hangs under the leaf its coordinates lead to. Once an insertion path gets deeper than
+// twice a balanced tree's depth the whole tree is rebuilt around medians, so depth stays O(log n). Points that
+// arrive sorted along an axis (novel behaviours tend to lie on the frontier) keep extending one path and
+// then cost a rebuild every O(log n) insertions; other orders rarely trigger one.
+class KDTree {
+	struct Node {
+		int point;
+		int axis;
+		int left;
+		int right;
+	};
+
+	int dims;
+	std::vector<float> points;
+	std::vector<Node> nodes;
+	int root = -1;
+
+	const float* at(int point) const {
+		return &points[point * dims];
+	}
+
+	float distance2(const float* a, const float* b) const {
+		float d = 0;
+		for (int i = 0; i < dims; i++) {
+			d += (a[i] - b[i]) * (a[i] - b[i]);
+		}
+		return d;
+	}
+
+	int build(std::vector<int>& order, int begin, int end, int depth) {
+		if (begin >= end)
+			return -1;
+		int axis = depth % dims;
+		int mid = (begin + end) / 2;
+		std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+			[&](int a, int b) { return at(a)[axis] < at(b)[axis]; });
+		int node = nodes.size();
+		nodes.push_back({ order[mid], axis, -1, -1 });
+		int left = build(order, begin, mid, depth + 1);
+		int right = build(order, mid + 1, end, depth + 1);
+		nodes[node].left = left;
+		nodes[node].right = right;
+		return node;
+	}
+
+	void rebuild() {
+		std::vector<int> order(size());
+		std::iota(order.begin(), order.end(), 0);
+		nodes.clear();
+		nodes.reserve(order.size());
+		root = build(order, 0, order.size(), 0);
+	}
+
+	// deepest insertion path tolerated before a rebuild
+	int maxDepth() const {
+		int depth = 1;
+		while ((1 << depth) <= size()) {
+			depth++;
+		}
+		return 2 * depth + 2;
+	}
+
+	// heap: max-heap on squared distance of the best k so far
+	void search(int node, const float* q, int k, int skip, std::vector<std::pair<float, int>>& heap) const {
+		if (node < 0)
+			return;
+		const Node& n = nodes[node];
+		if (n.point != skip) {
+			float d = distance2(q, at(n.point));
+			if (heap.size() < k) {
+				heap.push_back({ d, n.point });
+				std::push_heap(heap.begin(), heap.end());
+			}
+			else if (d < heap.front().first) {
+				std::pop_heap(heap.begin(), heap.end());
+				heap.back() = { d, n.point };
+				std::push_heap(heap.begin(), heap.end());
+			}
+		}
+		float diff = q[n.axis] - at(n.point)[n.axis];
+		search(diff < 0 ? n.left : n.right, q, k, skip, heap);
+		if (heap.size() < k || diff * diff < heap.front().first)
+			search(diff < 0 ? n.right : n.left, q, k, skip, heap);
+	}
+
+public:
+	KDTree(int dims) : dims(dims) {}
+
+	int size() const {
+		return points.size() / dims;
+	}
+
+	// replaces the tree with count points read from p (count * dims floats), in one median build
+	void assign(const float* p, int count) {
+		points.assign(p, p + count * dims);
+		rebuild();
+	}
+
+	void insert(const float* p) {
+		int point = size();
+		points.insert(points.end(), p, p + dims);
+		if (root < 0) {
+			nodes.push_back({ point, 0, -1, -1 });
+			root = nodes.size() - 1;
+			return;
+		}
+		int node = root;
+		for (int depth = 1; ; depth++) {
+			Node& n = nodes[node];
+			int& child = p[n.axis] < at(n.point)[n.axis] ? n.left : n.right;
+			if (child < 0) {
+				child = nodes.size();
+				nodes.push_back({ point, (n.axis + 1) % dims, -1, -1 });
+				if (depth > maxDepth())
+					rebuild();
+				return;
+			}
+			node = child;
+		}
+	}
+
+	void clear() {
+		points.clear();
+		nodes.clear();
+		root = -1;
+	}
+
+	// appends the squared distances of the k points nearest to q (other than point skip) to out
+	void nearest(const float* q, int k, std::vector<float>& out, int skip = -1) const {
+		std::vector<std::pair<float, int>> heap;
+		heap.reserve(k);
+		search(root, q, k, skip, heap);
+		for (auto& h : heap) {
+			out.push_back(h.first);
+		}
+	}
+
+	// appends the k points nearest to q (other than point skip) to out as (squared distance, point index)
+	void nearest(const float* q, int k, std::vector<std::pair<float, int>>& out, int skip = -1) const {
+		std::vector<std::pair<float, int>> heap;
+		heap.reserve(k);
+		search(root, q, k, skip, heap);
+		out.insert(out.end(), heap.begin(), heap.end());
+	}
+};
+
+// Novelty search: a bird is worth breeding for how differently it flew, not how long.
+// Its behaviour (Bird::describe) is scored by the mean distance to the k nearest behaviours of the rest of
+// the population and of an archive of past novel behaviours. Both are k-d trees, so a generation costs
+// O(n log(n + archive)) instead of a scan of the archive per bird.
+class NoveltySearch {
+	int k;
+	int perGeneration;
+	KDTree archive{ Bird::behaviourSize };
+	KDTree population{ Bird::behaviourSize };
+	std::vector<float> behaviours;
+	std::vector<float> flownBehaviours;
+	std::vector<float> novelty;
+
+public:
+	NoveltySearch(int k = 15, int perGeneration = 5) : k(std::max(1, k)), perGeneration(perGeneration) {}
+
+	// Replaces every bird's fitness with its novelty, then archives the perGeneration most novel behaviours.
+	// Birds that didn't fly this generation (grounded by the surrogate) score 0; birds answered by the fitness
+	// cache carry the recorded flight and are scored like the rest.
+	void score(std::vector<Bird>& birds, ThreadPool* pool = nullptr) {
+		const int dims = Bird::behaviourSize;
+		int n = birds.size();
+		behaviours.resize(n * dims);
+		novelty.assign(n, 0);
+		flownBehaviours.clear();
+		std::vector<int> flown;
+		for (int i = 0; i < n; i++) {
+			birds[i].describe(&behaviours[i * dims]);
+			if (birds[i].ticks > 0) {
+				flown.push_back(i);
+				flownBehaviours.insert(flownBehaviours.end(), &behaviours[i * dims], &behaviours[(i + 1) * dims]);
+			}
+		}
+		// population points are numbered in flown order
+		population.assign(flownBehaviours.data(), flown.size());
+
+		auto measure = [&](int begin, int end) {
+			std::vector<float> d;
+			for (int f = begin; f < end; f++) {
+				int i = flown[f];
+				d.clear();
+				population.nearest(&behaviours[i * dims], k, d, f);
+				archive.nearest(&behaviours[i * dims], k, d);
+				int m = std::min(k, (int)d.size());
+				std::partial_sort(d.begin(), d.begin() + m, d.end());
+				float sum = 0;
+				for (int j = 0; j < m; j++) {
+					sum += std::sqrt(d[j]);
+				}
+				novelty[i] = m > 0 ? sum / m : 0;
+			}
+		};
+		if (pool)
+			pool->parallelFor(flown.size(), measure);
+		else
+			measure(0, flown.size());
+
+		std::vector<int> order = flown;
+		int add = std::min(perGeneration, (int)order.size());
+		std::partial_sort(order.begin(), order.begin() + add, order.end(), [&](int a, int b) { return novelty[a] > novelty[b]; });
+		for (int j = 0; j < add; j++) {
+			archive.insert(&behaviours[order[j] * dims]);
+		}
+		for (int i = 0; i < n; i++) {
+			birds[i].fitness = novelty[i];
+		}
+	}
+
+	int archiveSize() const {
+		return archive.size();
+	}
+};
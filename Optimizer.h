@@ -0,0 +1,15 @@
+#pragma once
+#include <vector>
+
+// Ask/tell interface for engines that work on flat weight vectors instead of breeding Agents.
+// Each generation the caller asks for a population, flies it, and tells the engine the fitness of every
+// member (same order, higher is better).
+class Optimizer {
+public:
+	virtual ~Optimizer() {}
+	virtual int populationSize() const = 0;
+	virtual void ask(std::vector<std::vector<float>>& population) = 0;
+	virtual void tell(const std::vector<float>& fitness) = 0;
+	// best weights seen so far
+	virtual const std::vector<float>& best() const = 0;
+};
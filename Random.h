@@ -1,17 +1,79 @@
 #pragma once
 #include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <climits>
 
-// returns [0,1]
-float random() {
-	return rand() / (float)RAND_MAX;
+// splitmix64 - small, fast generator with 64 bits per draw
+class Rng {
+	uint64_t state;
+
+public:
+	Rng(uint64_t seed = 0) : state(seed) {}
+
+	// independent stream number index of a run seeded with seed
+	static Rng stream(uint64_t seed, uint64_t index) {
+		Rng mix(seed ^ (index * 0xD1B54A32D192ED03ull));
+		return Rng(mix.next());
+	}
+
+	void seed(uint64_t s) {
+		state = s;
+	}
+
+	uint64_t next() {
+		uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	// returns [0,1)
+	float uniform() {
+		return (next() >> 40) * (1.0f / 16777216.0f);
+	}
+	// returns [-1,1)
+	float uniform2() {
+		return uniform() * 2 - 1.0f;
+	}
+	// standard normal (Box-Muller)
+	float normal() {
+		double u1 = 1.0 - (next() >> 11) * (1.0 / 9007199254740992.0);	// (0,1]
+		double u2 = (next() >> 11) * (1.0 / 9007199254740992.0);
+		return (float)(std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2));
+	}
+	// returns [a,b]
+	int range(int a, int b) {
+		if (a > b)
+			std::swap(a, b);
+		return a + (int)(next() % (uint64_t)((int64_t)b - a + 1));
+	}
+
+	// number of failures before the first success of a trial with probability p
+	int geometric(float p) {
+		if (p <= 0)
+			return INT_MAX;
+		if (p >= 1)
+			return 0;
+		double u = 1.0 - (next() >> 11) * (1.0 / 9007199254740992.0);	// (0,1]
+		double skip = std::floor(std::log(u) / std::log1p(-(double)p));
+		return skip < INT_MAX ? (int)skip : INT_MAX;
+	}
+};
+
+// Generator of the calling thread. Workers reseed it per task (Rng::stream) so results don't depend
+// on which thread ran what.
+Rng& threadRng() {
+	thread_local Rng rng(std::random_device{}());
+	return rng;
 }
-// returns [-1,1]
+
+// returns [-1,1)
 float random2() {
-	return random() * 2 - 1.0f;
+	return threadRng().uniform2();
 }
 // returns [a,b]
 int randint(int a, int b) {
-	if (a > b)
-		std::swap(a, b);
-	return random() * (b - a) + a;
-}
\ No newline at end of file
+	return threadRng().range(a, b);
+}
@@ -0,0 +1,235 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include "Random.h"
+#include "Serialize.h"
+#include "NeuralNetwork.h"
+
+// Compact genome: the seed the weights were initialised from plus the (seed, strength) of every mutation
+// since. The weights are a pure function of the chain, so they only need to exist for birds about to fly.
+//
+// A chain is a list of immutable nodes, newest first, shared by every descendant: a child is its parent's
+// chain plus one node, so a population is a tree of lineages and copying a genome copies a pointer.
+// Replaying a whole lineage would grow with the run, so once a node is 2 * span mutations away from the
+// nearest stored weights, the ancestor span mutations back stores its weights (a snapshot) and forgets its own
+// ancestors. A rebuild therefore replays fewer than 2 * span mutations, and because the snapshot sits in an
+// ancestor, every lineage that descends from it shares one copy of the weights.
+//
+// Genomes are written against a table (one per checkpoint or message) so every node, snapshot included,
+// goes out once however many genomes share it: a genome costs its own new nodes (12 bytes each, usually
+// just its latest mutation) plus 8 bytes, and the weights of the population's few distinct snapshots are
+// written once.
+//
+// Seed chains only support mutation (Gaussian noise on every weight); there is no crossover.
+class SeedChain {
+public:
+	static const int span = 16;
+
+	struct Node {
+		// parent and weights are read and written with std::atomic_load/atomic_store only: a snapshot may be
+		// taken (and the parent dropped) while other threads walk through the node
+		mutable std::shared_ptr<const Node> parent;
+		mutable std::shared_ptr<const std::vector<float>> weights;
+		uint64_t seed;	// the initial seed for the root, the mutation's seed otherwise
+		float strength;	// 0 for the root
+		uint64_t key;	// content hash of the whole lineage up to here
+	};
+
+	// nodes already written to one checkpoint or message
+	struct WriteTable {
+		std::unordered_map<const Node*, uint32_t> ids;
+	};
+
+	// nodes already read from one checkpoint or message, by id
+	struct ReadTable {
+		std::vector<std::shared_ptr<const Node>> nodes;
+	};
+
+private:
+	std::shared_ptr<const Node> tip;
+
+	static uint64_t mix(uint64_t key, uint64_t seed, float strength) {
+		uint32_t bits;
+		std::memcpy(&bits, &strength, 4);
+		Rng rng(key ^ (seed * 0xD1B54A32D192ED03ull) ^ ((uint64_t)bits << 17));
+		return rng.next();
+	}
+
+	static std::shared_ptr<const Node> parentOf(const Node& n) {
+		return std::atomic_load(&n.parent);
+	}
+
+	static std::shared_ptr<const std::vector<float>> weightsOf(const Node& n) {
+		return std::atomic_load(&n.weights);
+	}
+
+	// the node's lineage back to (and including) the nearest node with weights or the root, newest first
+	static void lineage(const std::shared_ptr<const Node>& from, std::vector<std::shared_ptr<const Node>>& path) {
+		path.clear();
+		std::shared_ptr<const Node> n = from;
+		while (n) {
+			path.push_back(n);
+			if (weightsOf(*n))
+				break;
+			n = parentOf(*n);
+		}
+	}
+
+	// weights of the node that path (from lineage) starts with
+	static bool build(const std::vector<std::shared_ptr<const Node>>& path, NeuralNetwork& out) {
+		const Node& base = *path.back();
+		std::shared_ptr<const std::vector<float>> w = weightsOf(base);
+		if (w) {
+			if (w->size() != out.getWeights().size())
+				return false;
+			out.setWeights(*w);
+		}
+		else {
+			Rng rng(base.seed);
+			out.randomize(rng);
+		}
+		for (int i = (int)path.size() - 2; i >= 0; i--) {
+			out.perturb(path[i]->seed, path[i]->strength);
+		}
+		return true;
+	}
+
+	// stores the weights of the ancestor span mutations back once path (the tip's lineage) reaches 2 * span
+	static void snapshot(const std::vector<std::shared_ptr<const Node>>& path, const std::vector<int>& shape) {
+		if (path.size() <= 2 * span)
+			return;
+		std::vector<std::shared_ptr<const Node>> older(path.begin() + span, path.end());
+		NeuralNetwork weights(shape, false);
+		if (!build(older, weights))
+			return;
+		const Node& ancestor = *older.front();
+		std::atomic_store(&ancestor.weights, std::make_shared<const std::vector<float>>(weights.getWeights()));
+		std::atomic_store(&ancestor.parent, std::shared_ptr<const Node>());
+	}
+
+public:
+	SeedChain() {}
+	SeedChain(uint64_t initSeed) {
+		tip = std::make_shared<const Node>(Node{ nullptr, nullptr, initSeed, 0, mix(0x452821E638D01377ull, initSeed, 0) });
+	}
+
+	// content hash of the genome (equal chains, equal keys)
+	uint64_t key() const {
+		return tip ? tip->key : 0;
+	}
+
+	// regenerates the weights into out (already shaped); false for an empty chain or a snapshot that doesn't fit
+	bool build(NeuralNetwork& out) const {
+		if (!tip)
+			return false;
+		std::vector<std::shared_ptr<const Node>> path;
+		lineage(tip, path);
+		return build(path, out);
+	}
+
+	// whether the chain can be built into a brain with weights weights
+	bool fits(int weights) const {
+		if (!tip)
+			return false;
+		std::vector<std::shared_ptr<const Node>> path;
+		lineage(tip, path);
+		std::shared_ptr<const std::vector<float>> w = weightsOf(*path.back());
+		return !w || (int)w->size() == weights;
+	}
+
+	// Appends a mutation. brain gives the genome's shape; if built it holds this chain's weights before the
+	// call and the child's after it.
+	void mutate(uint64_t seed, float strength, NeuralNetwork& brain, bool built) {
+		tip = std::make_shared<const Node>(Node{ tip, nullptr, seed, strength, mix(key(), seed, strength) });
+		if (built)
+			brain.perturb(seed, strength);
+		std::vector<std::shared_ptr<const Node>> path;
+		lineage(tip, path);
+		snapshot(path, brain.getShape());
+	}
+
+	// binary form, against table: u32 anchor (1 + id of the newest node already in the table, or 0), then if
+	// the anchor is 0 the oldest node (u64 key, u64 seed, u32 weight count (0 for a root), that many f32 weights),
+	// then u32 count and per newer node u64 seed + f32 strength, oldest first
+	void write(ByteWriter& out, WriteTable& table) const {
+		std::vector<const Node*> fresh;
+		uint32_t anchor = 0;
+		std::shared_ptr<const Node> n = tip;
+		while (n) {
+			auto known = table.ids.find(n.get());
+			if (known != table.ids.end()) {
+				anchor = known->second + 1;
+				break;
+			}
+			fresh.push_back(n.get());
+			if (weightsOf(*n))
+				break;
+			n = parentOf(*n);
+		}
+		out.u32(anchor);
+		int newest = (int)fresh.size() - 1;
+		if (anchor == 0 && !fresh.empty()) {
+			const Node& base = *fresh[newest];
+			std::shared_ptr<const std::vector<float>> w = weightsOf(base);
+			out.u64(base.key);
+			out.u64(base.seed);
+			out.u32(w ? w->size() : 0);
+			if (w) {
+				for (float x : *w) {
+					out.f32(x);
+				}
+			}
+			uint32_t id = table.ids.size();
+			table.ids[&base] = id;
+			newest--;
+		}
+		out.u32(newest + 1);
+		for (int i = newest; i >= 0; i--) {
+			out.u64(fresh[i]->seed);
+			out.f32(fresh[i]->strength);
+			uint32_t id = table.ids.size();
+			table.ids[fresh[i]] = id;
+		}
+	}
+
+	bool read(ByteReader& in, ReadTable& table) {
+		uint32_t anchor = in.u32();
+		if (!in.ok || anchor > table.nodes.size())
+			return false;
+		std::shared_ptr<const Node> n;
+		if (anchor > 0) {
+			n = table.nodes[anchor - 1];
+		}
+		else {
+			uint64_t key = in.u64();
+			uint64_t seed = in.u64();
+			uint32_t weights = in.u32();
+			if (!in.ok || weights > in.remaining() / 4)
+				return false;
+			std::shared_ptr<const std::vector<float>> w;
+			if (weights > 0) {
+				std::vector<float> values(weights);
+				for (float& x : values) {
+					x = in.f32();
+				}
+				w = std::make_shared<const std::vector<float>>(std::move(values));
+			}
+			n = std::make_shared<const Node>(Node{ nullptr, w, seed, 0, key });
+			table.nodes.push_back(n);
+		}
+		uint32_t count = in.u32();
+		if (!in.ok || count > in.remaining() / 12)
+			return false;
+		for (uint32_t i = 0; i < count; i++) {
+			uint64_t seed = in.u64();
+			float strength = in.f32();
+			n = std::make_shared<const Node>(Node{ n, nullptr, seed, strength, mix(n->key, seed, strength) });
+			table.nodes.push_back(n);
+		}
+		tip = n;
+		return in.ok;
+	}
+};
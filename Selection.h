@@ -0,0 +1,263 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include "Random.h"
+
+// Parent selection strategy.
+// prepare() is called once per generation with the fitness of every individual and the number of parents
+// that will be drawn, select() then returns the index of parent number draw.
+// select() must be safe to call from several threads at once, all its randomness comes from rng.
+// A selection that wants more than one objective per individual says so with objectives(); prepare() then
+// gets that many values per individual, row by row, all to be maximised.
+class Selection {
+public:
+	virtual ~Selection() {}
+	virtual void prepare(const std::vector<float>& fitness, int nDraws, Rng& rng) = 0;
+	virtual int select(int draw, Rng& rng) const = 0;
+	virtual int objectives() const {
+		return 1;
+	}
+};
+
+// Fitness-proportional selection.
+// The cumulative fitness table is built once per generation, every draw is then a binary search - O(log N).
+class RouletteWheel : public Selection {
+	std::vector<double> cdf;
+
+public:
+	void clear() {
+		cdf.clear();
+	}
+
+	void reserve(size_t n) {
+		cdf.reserve(n);
+	}
+
+	void add(float fitness) {
+		double prev = cdf.size() > 0 ? cdf[cdf.size() - 1] : 0;
+		cdf.push_back(prev + std::max(fitness, 0.0f));
+	}
+
+	void prepare(const std::vector<float>& fitness, int nDraws, Rng& rng) override {
+		clear();
+		reserve(fitness.size());
+		for (float f : fitness) {
+			add(f);
+		}
+	}
+
+	int select(int draw, Rng& rng) const override {
+		double total = cdf[cdf.size() - 1];
+		if (total <= 0)
+			return rng.range(0, cdf.size() - 1);
+
+		double target = rng.uniform() * total;
+		int i = std::upper_bound(cdf.begin(), cdf.end(), target) - cdf.begin();
+		return std::min(i, (int)cdf.size() - 1);
+	}
+
+	size_t size() const {
+		return cdf.size();
+	}
+};
+
+// k-way tournament, O(k) per draw and no global state besides the fitness values
+class TournamentSelection : public Selection {
+	std::vector<float> fitness;
+	int k;
+
+public:
+	TournamentSelection(int k = 3) : k(std::max(k, 1)) {}
+
+	void prepare(const std::vector<float>& f, int nDraws, Rng& rng) override {
+		fitness = f;
+	}
+
+	int select(int draw, Rng& rng) const override {
+		int n = fitness.size();
+		int best = rng.range(0, n - 1);
+		for (int i = 1; i < k; i++) {
+			int c = rng.range(0, n - 1);
+			if (fitness[c] > fitness[best])
+				best = c;
+		}
+		return best;
+	}
+};
+
+// Linear ranking: the worst individual gets weight 2-pressure, the best gets pressure (1 < pressure <= 2).
+// Only the order of the fitness values matters, so one outlier can't take over the population.
+class RankSelection : public Selection {
+	std::vector<int> order;
+	RouletteWheel wheel;
+	float pressure;
+
+public:
+	RankSelection(float pressure = 1.5f) : pressure(std::min(std::max(pressure, 1.0f), 2.0f)) {}
+
+	void prepare(const std::vector<float>& fitness, int nDraws, Rng& rng) override {
+		int n = fitness.size();
+		order.resize(n);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](int a, int b) { return fitness[a] < fitness[b]; });
+
+		wheel.clear();
+		wheel.reserve(n);
+		for (int r = 0; r < n; r++) {
+			float w = n > 1 ? (2 - pressure) + 2 * (pressure - 1) * r / (float)(n - 1) : 1.0f;
+			wheel.add(w);
+		}
+	}
+
+	int select(int draw, Rng& rng) const override {
+		return order[wheel.select(draw, rng)];
+	}
+};
+
+// Stochastic universal sampling: all parents are drawn in one O(N) pass with evenly spaced pointers,
+// then shuffled so that consecutive draws don't pair up neighbours.
+class SUSSelection : public Selection {
+	std::vector<int> picks;
+
+public:
+	void prepare(const std::vector<float>& fitness, int nDraws, Rng& rng) override {
+		picks.clear();
+		picks.reserve(nDraws);
+		if (nDraws <= 0)
+			return;
+
+		double total = 0;
+		for (float f : fitness) {
+			total += std::max(f, 0.0f);
+		}
+		if (total <= 0) {
+			for (int i = 0; i < nDraws; i++) {
+				picks.push_back(rng.range(0, fitness.size() - 1));
+			}
+			return;
+		}
+
+		double step = total / nDraws;
+		double pointer = rng.uniform() * step;
+		double cumulative = 0;
+		int i = 0;
+		for (int d = 0; d < nDraws; d++) {
+			while (i < (int)fitness.size() - 1 && cumulative + std::max(fitness[i], 0.0f) < pointer) {
+				cumulative += std::max(fitness[i], 0.0f);
+				i++;
+			}
+			picks.push_back(i);
+			pointer += step;
+		}
+
+		for (int j = picks.size() - 1; j > 0; j--) {
+			std::swap(picks[j], picks[rng.range(0, j)]);
+		}
+	}
+
+	int select(int draw, Rng& rng) const override {
+		return picks[draw % picks.size()];
+	}
+};
+
+// NSGA-II: individuals are ordered by non-dominated front, then by crowding distance (how isolated they are
+// on their front, objectives scaled to the front's range), and every draw is a binary tournament on that order.
+// Fronts come from an efficient non-dominated sort (ENS-BS): after a lexicographic sort only earlier
+// individuals can dominate later ones, and since an individual dominated by front k is also dominated by every
+// front before it, its front is found by binary search over the fronts. That is still O(M N^2) in the worst
+// case, but only individuals that could matter are ever compared.
+class NSGA2Selection : public Selection {
+	int m;
+	int n = 0;
+	std::vector<int> rank;
+	std::vector<float> crowding;
+
+	bool dominates(const float* a, const float* b) const {
+		bool better = false;
+		for (int k = 0; k < m; k++) {
+			if (a[k] < b[k])
+				return false;
+			if (a[k] > b[k])
+				better = true;
+		}
+		return better;
+	}
+
+public:
+	NSGA2Selection(int objectives = 3) : m(std::max(1, objectives)) {}
+
+	int objectives() const override {
+		return m;
+	}
+
+	void prepare(const std::vector<float>& values, int nDraws, Rng& rng) override {
+		n = values.size() / m;
+		auto at = [&](int i) { return &values[i * m]; };
+		std::vector<int> order(n);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](int a, int b) {
+			return std::lexicographical_compare(at(b), at(b) + m, at(a), at(a) + m);
+		});
+
+		std::vector<std::vector<int>> fronts;
+		rank.assign(n, 0);
+		for (int i : order) {
+			int lo = 0, hi = fronts.size();
+			while (lo < hi) {
+				int mid = (lo + hi) / 2;
+				const std::vector<int>& front = fronts[mid];
+				bool dominated = false;
+				for (int j = front.size() - 1; j >= 0 && !dominated; j--) {
+					dominated = dominates(at(front[j]), at(i));
+				}
+				if (dominated)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			if (lo == fronts.size())
+				fronts.emplace_back();
+			fronts[lo].push_back(i);
+			rank[i] = lo;
+		}
+
+		crowding.assign(n, 0);
+		for (std::vector<int>& front : fronts) {
+			for (int k = 0; k < m; k++) {
+				std::sort(front.begin(), front.end(), [&](int a, int b) { return at(a)[k] < at(b)[k]; });
+				float range = at(front.back())[k] - at(front.front())[k];
+				crowding[front.front()] = crowding[front.back()] = INFINITY;
+				if (range <= 0)
+					continue;
+				for (int j = 1; j + 1 < front.size(); j++) {
+					crowding[front[j]] += (at(front[j + 1])[k] - at(front[j - 1])[k]) / range;
+				}
+			}
+		}
+	}
+
+	int select(int draw, Rng& rng) const override {
+		int a = rng.range(0, n - 1);
+		int b = rng.range(0, n - 1);
+		if (rank[a] != rank[b])
+			return rank[a] < rank[b] ? a : b;
+		return crowding[a] >= crowding[b] ? a : b;
+	}
+};
+
+// name is one of: roulette, tournament, rank, sus, nsga2
+std::unique_ptr<Selection> makeSelection(const std::string& name, int tournamentSize = 3, float rankPressure = 1.5f) {
+	if (name == "tournament")
+		return std::unique_ptr<Selection>(new TournamentSelection(tournamentSize));
+	if (name == "rank")
+		return std::unique_ptr<Selection>(new RankSelection(rankPressure));
+	if (name == "sus")
+		return std::unique_ptr<Selection>(new SUSSelection());
+	if (name == "nsga2")
+		return std::unique_ptr<Selection>(new NSGA2Selection(3));
+	return std::unique_ptr<Selection>(new RouletteWheel());
+}
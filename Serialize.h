@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+// Little-endian binary encoding for everything that goes over the wire or to disk
+class ByteWriter {
+public:
+	std::vector<uint8_t> bytes;
+
+	void u8(uint8_t v) {
+		bytes.push_back(v);
+	}
+
+	void u16(uint16_t v) {
+		bytes.push_back(v & 0xFF);
+		bytes.push_back(v >> 8);
+	}
+
+	void u32(uint32_t v) {
+		for (int i = 0; i < 4; i++) {
+			bytes.push_back((v >> (8 * i)) & 0xFF);
+		}
+	}
+
+	void u64(uint64_t v) {
+		u32((uint32_t)v);
+		u32((uint32_t)(v >> 32));
+	}
+
+	void f32(float v) {
+		uint32_t bits;
+		std::memcpy(&bits, &v, 4);
+		u32(bits);
+	}
+};
+
+// Reads what ByteWriter wrote. Reading past the end sets ok to false and returns zeros.
+class ByteReader {
+	const uint8_t* data;
+	size_t size;
+	size_t pos = 0;
+
+public:
+	bool ok = true;
+
+	ByteReader(const std::vector<uint8_t>& bytes) : data(bytes.data()), size(bytes.size()) {}
+	ByteReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+	bool has(size_t n) {
+		if (pos + n > size)
+			ok = false;
+		return ok;
+	}
+
+	size_t remaining() const {
+		return size - pos;
+	}
+
+	uint8_t u8() {
+		if (!has(1))
+			return 0;
+		return data[pos++];
+	}
+
+	uint16_t u16() {
+		if (!has(2))
+			return 0;
+		uint16_t v = data[pos] | (data[pos + 1] << 8);
+		pos += 2;
+		return v;
+	}
+
+	uint32_t u32() {
+		if (!has(4))
+			return 0;
+		uint32_t v = 0;
+		for (int i = 0; i < 4; i++) {
+			v |= (uint32_t)data[pos + i] << (8 * i);
+		}
+		pos += 4;
+		return v;
+	}
+
+	uint64_t u64() {
+		uint64_t lo = u32();
+		uint64_t hi = u32();
+		return lo | (hi << 32);
+	}
+
+	float f32() {
+		uint32_t bits = u32();
+		float v;
+		std::memcpy(&v, &bits, 4);
+		return v;
+	}
+};
@@ -0,0 +1,658 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cmath>
+#include <iostream>
+#include "olcPixelGameEngine.h"
+#include "NeuralNetwork.h"
+#include "SeedChain.h"
+#include "Topology.h"
+#include "Evolution.h"
+#include "Config.h"
+
+class Bird : public Agent<Bird> {
+	static const float thrust;
+	static const float gravity;
+
+	// the weights; for a seed chain only a cache, materialised on first use and released once the bird is shelved
+	mutable NeuralNetwork brain;
+	mutable bool built = true;
+	// set when the genome is a seed chain
+	SeedChain genes;
+	bool chained = false;
+	// set when the genome is a topology (genome = neat); plan is its compiled forward pass and brain is unused
+	Topology topology;
+	Plan plan;
+	bool grown = false;
+	// mean |weight| of the topology's enabled genes (the sparsity objective), set whenever it is compiled
+	float topologyWeight = 0;
+	// self-adaptive mutation: the genome's own per-weight chance and step size, used by breed() instead of the caller's
+	bool adaptive = false;
+	float ownChance = 0;
+	float ownStep = 0;
+
+	// compiles the topology into plan
+	void grow() {
+		topology.compile(plan);
+		topologyWeight = topology.meanWeight();
+	}
+
+	// Log-normal self-adaptation: the child's rates are the geometric mean of its parents' times exp(tau * N(0,1)),
+	// with tau = 1/sqrt(weights), drawn before the weights are mutated with them
+	void inheritRates(const Bird& a, const Bird& b, Rng& rng) {
+		const Bird& other = b.adaptive ? b : a;
+		float n = (float)(a.grown ? a.topology.size() : a.brain.weightCount());
+		float tau = 1 / std::sqrt(n);
+		ownChance = std::sqrt(a.ownChance * other.ownChance) * std::exp(tau * rng.normal());
+		ownStep = std::sqrt(a.ownStep * other.ownStep) * std::exp(tau * rng.normal());
+		ownChance = std::min(std::max(ownChance, 1 / n), 0.5f);
+		ownStep = std::min(std::max(ownStep, 1e-3f), 2.0f);
+	}
+
+public:
+	static constexpr int trailSamples = 8;
+	static const float trailInterval;
+	static constexpr int behaviourSize = trailSamples + 1;
+
+	olc::vf2d pos;
+	float v = 0;
+	float r = 20;
+	bool alive = true;
+
+	// what the current flight looked like (novelty search, MAP-Elites): ticks flown, flaps, the sum of the
+	// height (0 = top, 1 = bottom) over all ticks and the height at the end of every trailInterval seconds
+	int ticks = 0;
+	int flaps = 0;
+	float heightSum = 0;
+	float trail[trailSamples] = {};
+	// vertical distance from the centre of the gap the bird has to fly through next, in world heights, at
+	// its last tick (racing ranks birds that are still alive, and so have the same fitness, by it)
+	float gapOffset = 0;
+	// stopped by racing while still alive: fitness is only a lower bound that depends on the other flyers
+	bool cut = false;
+
+	Bird(float x, float y, const std::vector<int>& brainShape, Rng& rng = threadRng()) : brain(brainShape, true, rng), pos(x,y) {}
+	Bird(float x, float y, const NeuralNetwork& nn) : brain(nn), pos(x,y) {}
+	Bird(float x, float y, const std::vector<int>& brainShape, const SeedChain& chain) : brain(brainShape, false), built(false), genes(chain), chained(true), pos(x,y) {
+		brain.release();
+	}
+	Bird(float x, float y, const std::vector<int>& brainShape, const Topology& t) : brain(brainShape, false), topology(t), grown(true), pos(x,y) {
+		grow();
+	}
+
+	// the flap output for nnInput
+	float think(std::vector<float>& nnInput) {
+		return grown ? plan.run(nnInput) : getBrain().evaluate(nnInput)[0];
+	}
+
+	// Regenerates a seed chain's weights if they aren't cached. Not thread-safe for one bird: a bird only
+	// flies on one thread, and code that reads other birds' weights in parallel materialises them first.
+	void materialise() const {
+		if (built)
+			return;
+		brain.allocate();
+		genes.build(brain);
+		built = true;
+	}
+
+	// Drops a seed chain's cached weights: the bird won't fly again (a parent or a retired bird), so only the
+	// chain has to stay (Agent interface)
+	void shelve() {
+		if (!chained || !built)
+			return;
+		brain.release();
+		built = false;
+	}
+
+	void decide(std::vector<float>& nnInput) {
+		if (think(nnInput) > 0.5f) {
+			v += thrust;
+			flaps++;
+		}
+	}
+
+	void update(float elapsedTime) {
+		v += gravity * elapsedTime;
+		pos.y += v * elapsedTime;
+	}
+
+	void draw(olc::PixelGameEngine* canvas) {
+		canvas->FillCircle(pos, r, olc::GREY);
+	}
+
+	const NeuralNetwork& getBrain() const {
+		materialise();
+		return brain;
+	}
+
+	NeuralNetwork& getBrain() {
+		materialise();
+		return brain;
+	}
+
+	// null unless the genome is a topology
+	const Topology* getTopology() const {
+		return grown ? &topology : nullptr;
+	}
+
+	void drawBrain(olc::PixelGameEngine* canvas, int x, int y) {
+		if (grown)
+			plan.draw(canvas, x, y);
+		else
+			getBrain().draw(canvas, x, y);
+	}
+
+	void mutate(float chance) {
+		getBrain().mutate(chance);
+	}
+
+	Bird intercourse(const Bird& partner, float chance = 0, float lr = 0.2f) {
+		Bird child(pos.x, pos.y, getBrain().intercourse(partner.getBrain(), chance, lr));
+		return child;
+	}
+
+	// Overwrites this bird in place with a child of a and b, reusing its brain storage (Agent interface)
+	// Seed-chain genomes inherit a's chain plus one new full-weight mutation of strength lr (b is unused); the
+	// child's weights are only computed here when a's are cached, otherwise when the child first flies.
+	// weight genomes get crossover and per-weight mutation, topologies NEAT crossover and mutation which then
+	// compiles the child's plan. Self-adaptive genomes mutate with their own rates.
+	void breed(const Bird& a, const Bird& b, float chance, float lr, Rng& rng) {
+		adaptive = a.adaptive;
+		if (adaptive) {
+			inheritRates(a, a.chained ? a : b, rng);
+			chance = ownChance;
+			lr = ownStep;
+		}
+		grown = a.grown;
+		if (a.chained) {
+			genes = a.genes;
+			chained = true;
+			built = a.built;
+			if (built)
+				brain = a.brain;
+			else
+				brain.release();
+			genes.mutate(rng.next(), lr, brain, built);
+		}
+		else if (a.grown) {
+			const Bird& partner = b.grown ? b : a;
+			bool aFitter = a.fitness >= partner.fitness;
+			Topology::cross(aFitter ? a.topology : partner.topology, aFitter ? partner.topology : a.topology, topology, rng);
+			topology.mutate(chance, lr, rng);
+			grow();
+			chained = false;
+			built = true;
+		}
+		else {
+			NeuralNetwork::breed(a.getBrain(), b.getBrain(), brain, chance, lr, rng);
+			chained = false;
+			built = true;
+		}
+		reset();
+	}
+
+	// gives the genome its own mutation rates, which its children inherit and perturb (config.selfAdaptive)
+	void adaptMutation(float chance, float step) {
+		adaptive = true;
+		ownChance = chance;
+		ownStep = step;
+	}
+
+	bool adaptsMutation() const {
+		return adaptive;
+	}
+
+	float mutationChance() const {
+		return ownChance;
+	}
+
+	float mutationStep() const {
+		return ownStep;
+	}
+
+	uint64_t genomeHash() const {
+		return grown ? topology.hash() : chained ? genes.key() : brain.hash();
+	}
+
+	// replaces the genome with plain weights (engines that work on flat weight vectors)
+	void setWeights(const float* weights) {
+		brain.allocate();
+		built = true;
+		brain.setWeights(weights);
+		chained = false;
+		grown = false;
+		reset();
+	}
+
+	void setWeights(const std::vector<float>& weights) {
+		setWeights(weights.data());
+	}
+
+	// genome binary form: u8 kind (0 = weights, 1 = seed chain, 4 = topology, +2 when self-adaptive), f32 chance
+	// and f32 step if self-adaptive, then the NeuralNetwork, SeedChain or Topology binary form. Seed chains are
+	// written against chains, shared by every genome of one checkpoint or message.
+	void writeGenome(ByteWriter& out, SeedChain::WriteTable& chains) const {
+		out.u8((chained ? 1 : grown ? 4 : 0) | (adaptive ? 2 : 0));
+		if (adaptive) {
+			out.f32(ownChance);
+			out.f32(ownStep);
+		}
+		if (chained)
+			genes.write(out, chains);
+		else if (grown)
+			topology.write(out);
+		else
+			brain.write(out);
+	}
+
+	bool readGenome(ByteReader& in, const std::vector<int>& brainShape, SeedChain::ReadTable& chains) {
+		uint8_t kind = in.u8();
+		adaptive = kind & 2;
+		if (adaptive) {
+			ownChance = in.f32();
+			ownStep = in.f32();
+		}
+		kind &= ~2;
+		grown = false;
+		if (kind == 4) {
+			if (!Topology::read(in, brainShape.front(), brainShape.back(), topology))
+				return false;
+			grow();
+			chained = false;
+			built = true;
+			grown = true;
+			return true;
+		}
+		if (kind == 1) {
+			if (!genes.read(in, chains))
+				return false;
+			if (brain.getShape() != brainShape)
+				brain = NeuralNetwork(brainShape, false);
+			chained = true;
+			built = false;
+			brain.release();
+			return genes.fits(brain.weightCount());
+		}
+		chained = false;
+		built = true;
+		brain.allocate();
+		return kind == 0 && NeuralNetwork::read(in, brainShape, brain);
+	}
+
+	// ready for a new flight with the same brain
+	void reset() {
+		v = 0;
+		alive = true;
+		fitness = 0;
+		ticks = 0;
+		flaps = 0;
+		heightSum = 0;
+		gapOffset = 0;
+		cut = false;
+	}
+
+	// takes over the fitness and flight record of a bird with the same genome that flew the same course
+	void copyFlight(const Bird& other) {
+		fitness = other.fitness;
+		ticks = other.ticks;
+		flaps = other.flaps;
+		heightSum = other.heightSum;
+		std::copy(other.trail, other.trail + trailSamples, trail);
+	}
+
+	// multi-objective selection: survival time, fewest flaps per tick (energy, so living longer isn't
+	// penalised for the flaps it takes), smallest mean |weight| (sparsity). A bird with no recorded ticks
+	// (grounded by the surrogate) gets the worst energy, a flap every tick.
+	void objectives(float* out, int m) const {
+		float values[3] = { fitness, ticks > 0 ? -(float)flaps / ticks : -1, -topologyWeight };
+		if (!grown) {
+			const std::vector<float>& w = getBrain().getWeights();
+			for (float x : w) {
+				values[2] -= std::abs(x);
+			}
+			values[2] /= std::max<size_t>(1, w.size());
+		}
+		for (int i = 0; i < m; i++) {
+			out[i] = i < 3 ? values[i] : 0;
+		}
+	}
+
+	// behaviourSize values: the trail (the last height reached holds for the rest of it), then the share
+	// of ticks with a flap
+	void describe(float* out) const {
+		int recorded = std::min(trailSamples, (int)(fitness / trailInterval) + 1);
+		for (int i = 0; i < trailSamples; i++) {
+			out[i] = ticks > 0 ? trail[std::min(i, recorded - 1)] : 0.5f;
+		}
+		out[trailSamples] = ticks > 0 ? (float)flaps / ticks : 0;
+	}
+};
+constexpr int Bird::trailSamples;
+constexpr int Bird::behaviourSize;
+const float Bird::trailInterval = 1;
+const float Bird::gravity = 1000;
+const float Bird::thrust = -500;
+
+class Obstacle {
+public:
+	olc::vf2d pos;
+	int gap;
+	int width;
+
+	Obstacle(float x = 0, float y = 0, int gap = 30, int width = 30) : pos(x, y), gap(gap), width(width) {}
+
+	void draw(olc::PixelGameEngine* canvas) {
+		canvas->FillRect(olc::vi2d( pos.x, 0 ), olc::vd2d( width, pos.y - gap ));
+		canvas->FillRect(olc::vi2d( pos.x, pos.y + gap ), olc::vd2d( width, canvas->ScreenHeight() - (pos.y + gap) ));
+	}
+
+	bool is_colliding(const Bird& bird) const {
+		if (bird.pos.x + bird.r < pos.x || bird.pos.x-bird.r > pos.x+width)
+			return false;
+
+		return bird.pos.y - bird.r < pos.y - gap || bird.pos.y + bird.r > pos.y + gap;
+	}
+};
+
+
+// Layout of the world the birds fly through
+struct World {
+	int width = 1000;
+	int height = 600;
+	float speed = 50;
+	int obstacleGap = 300;
+	int birdX = 50;
+
+	World() {}
+	World(const Config& config) : speed(config.speed), obstacleGap(config.obstacleGap) {}
+};
+
+// One run through the pipes. Obstacle heights come from the course's own generator,
+// so the same seed always produces the same course.
+class Course {
+	World world;
+	Rng rng;
+	std::vector<Obstacle> obstacles;
+
+	void pushObstacle() {
+		const int verGap = 50;
+		const int width = 30;
+		const int start = 200;
+		if (obstacles.size() == 0) {
+			obstacles.emplace_back(Obstacle(start, rng.range(verGap / 2, world.height - verGap / 2), verGap, width));
+		}
+		else {
+			Obstacle& o = obstacles[obstacles.size() - 1];
+			obstacles.emplace_back(Obstacle(o.pos.x + o.width + world.obstacleGap, rng.range(verGap / 2, world.height - verGap / 2), verGap, width));
+		}
+	}
+
+	Obstacle& nearestObstacle(float birdR) {
+		int i = 0;
+		while (obstacles[i].pos.x + obstacles[i].width < world.birdX - birdR) {
+			i++;
+		}
+		return obstacles[i];
+	}
+
+	void fly(Bird& b, const Obstacle& nearest, float elapsedTime) {
+		float distance = nearest.pos.x + nearest.width - (b.pos.x + b.r);
+		distance /= world.width;
+		float ybpos = b.pos.y / world.height;
+		float yvel = b.v / (world.height * 2);
+		float yppos = nearest.pos.y / world.height * 0.98f + 0.01;
+		std::vector<float> input = { ybpos, yvel, distance, yppos };
+		b.decide(input);
+		b.update(elapsedTime);
+		b.fitness += elapsedTime;
+		b.ticks++;
+		float height = std::min(std::max(b.pos.y / world.height, 0.0f), 1.0f);
+		b.heightSum += height;
+		int sample = (int)(b.fitness / Bird::trailInterval);
+		if (sample < Bird::trailSamples)
+			b.trail[sample] = height;
+		b.gapOffset = std::abs(b.pos.y - nearest.pos.y) / world.height;
+		if (nearest.is_colliding(b) || b.pos.y + b.r < 0 || b.pos.y - b.r > world.height) {
+			b.alive = false;
+		}
+	}
+
+	void updateObstacles(float elapsedTime) {
+		for (Obstacle& o : obstacles) {
+			o.pos.x -= world.speed * elapsedTime;
+		}
+		while (obstacles.size() > 0 && obstacles[0].pos.x+obstacles[0].width < 0) {
+			obstacles.erase(obstacles.begin());
+		}
+		while (obstacles.size() == 0 || obstacles[obstacles.size() - 1].pos.x < world.width) {
+			pushObstacle();
+		}
+	}
+
+public:
+	float time = 0;
+
+	Course(const World& world, uint64_t seed = 0) : world(world), rng(seed) {}
+
+	void reset(uint64_t seed) {
+		rng.seed(seed);
+		obstacles.clear();
+		time = 0;
+	}
+
+	void placeBirds(std::vector<Bird>& birds) {
+		for (Bird& b : birds) {
+			b.pos = { (float)world.birdX, world.height / 2.0f };
+		}
+	}
+
+	// Advances the course and every living bird by one tick. Returns false once all birds are dead.
+	bool step(std::vector<Bird>& birds, float elapsedTime) {
+		time += elapsedTime;
+
+		updateObstacles(elapsedTime);
+		Obstacle& nearest = nearestObstacle(birds[0].r);
+
+		bool anyAlive = false;
+		for (Bird& b : birds) {
+			if (!b.alive)
+				continue;
+
+			anyAlive = true;
+			fly(b, nearest, elapsedTime);
+		}
+		return anyAlive;
+	}
+
+	// Same for a course flown by a single bird
+	bool step(Bird& b, float elapsedTime) {
+		if (!b.alive)
+			return false;
+
+		time += elapsedTime;
+		updateObstacles(elapsedTime);
+		fly(b, nearestObstacle(b.r), elapsedTime);
+		return true;
+	}
+
+	void draw(olc::PixelGameEngine* canvas) {
+		for (Obstacle& o : obstacles) {
+			o.draw(canvas);
+		}
+	}
+};
+
+// Headless evaluation: flies birds through the course with the given seed until all are dead or maxTime runs out.
+// Returns the time the last bird survived.
+float simulate(std::vector<Bird>& birds, const World& world, uint64_t seed, float maxTime, float elapsedTime = 0.016f) {
+	Course course(world, seed);
+	course.placeBirds(birds);
+	while (course.step(birds, elapsedTime) && course.time < maxTime);
+	return course.time;
+}
+
+// Same, with every bird flying its own copy of the course on the thread pool. Courses only depend on the
+// seed, so each bird gets the fitness the serial version would give it.
+float simulate(std::vector<Bird>& birds, const World& world, uint64_t seed, float maxTime, ThreadPool& pool, float elapsedTime = 0.016f) {
+	std::vector<float> times(birds.size());
+	pool.parallelFor(birds.size(), [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			Course course(world, seed);
+			birds[i].pos = { (float)world.birdX, world.height / 2.0f };
+			while (course.step(birds[i], elapsedTime) && course.time < maxTime);
+			times[i] = course.time;
+		}
+	});
+	return times.empty() ? 0 : *std::max_element(times.begin(), times.end());
+}
+
+// Successive halving: every living bird flies the first firstRung seconds of the course, the best keep
+// fraction of those still alive flies on to firstRung / keep seconds, and so on up to maxTime.
+// Birds resume their own copy of the course, so no prefix is flown twice. Fitness stays survival time
+// on the same course: a bird cut at a rung keeps the time it reached (a lower bound), which never beats a
+// bird that was promoted past it, so ranks are comparable across rungs. Every bird alive at a rung has the
+// same survival time, so they are ranked by how close they are to the centre of the next gap.
+float race(std::vector<Bird>& birds, const World& world, uint64_t seed, float maxTime, float firstRung, float keep, ThreadPool* pool = nullptr, float elapsedTime = 0.016f) {
+	keep = std::min(std::max(keep, 0.01f), 1.0f);
+	std::vector<Course> courses(birds.size(), Course(world, seed));
+	std::vector<int> active;
+	for (int i = 0; i < birds.size(); i++) {
+		if (birds[i].alive) {
+			birds[i].pos = { (float)world.birdX, world.height / 2.0f };
+			active.push_back(i);
+		}
+	}
+
+	float budget = std::min(std::max(firstRung, elapsedTime), maxTime);
+	float time = 0;
+	while (!active.empty()) {
+		auto fly = [&](int begin, int end) {
+			for (int k = begin; k < end; k++) {
+				int i = active[k];
+				while (courses[i].step(birds[i], elapsedTime) && courses[i].time < budget);
+			}
+		};
+		if (pool)
+			pool->parallelFor(active.size(), fly);
+		else
+			fly(0, active.size());
+		for (int i : active) {
+			time = std::max(time, courses[i].time);
+		}
+		if (budget >= maxTime)
+			break;
+
+		// the quota is taken from everyone who flew this rung; only the living can use it
+		int quota = (int)std::ceil(keep * active.size());
+		std::vector<int> living;
+		for (int i : active) {
+			if (birds[i].alive)
+				living.push_back(i);
+		}
+		if (living.size() > quota) {
+			std::stable_sort(living.begin(), living.end(), [&](int a, int b) {
+				if (birds[a].fitness != birds[b].fitness)
+					return birds[a].fitness > birds[b].fitness;
+				return birds[a].gapOffset < birds[b].gapOffset;
+			});
+			for (int k = quota; k < living.size(); k++) {
+				birds[living[k]].alive = false;
+				birds[living[k]].cut = true;
+			}
+			living.resize(quota);
+		}
+		active = living;
+		budget = std::min(budget / keep, maxTime);
+	}
+	for (int i : active) {
+		birds[i].alive = false;
+	}
+	return time;
+}
+
+// Fitness of every bird on the course with seed, flown the way config asks for (whole flights or racing)
+float evaluate(std::vector<Bird>& birds, const World& world, uint64_t seed, const Config& config, ThreadPool* pool = nullptr) {
+	if (config.racing)
+		return race(birds, world, seed, config.maxGenTime, config.racingFirstRung, config.racingKeep, pool);
+	return pool ? simulate(birds, world, seed, config.maxGenTime, *pool) : simulate(birds, world, seed, config.maxGenTime);
+}
+
+// A random bird with the genome representation config asks for
+Bird makeBird(const Config& config, const World& world, Rng& rng) {
+	Bird b = config.genome == "seedchain"
+		? Bird(world.birdX, world.height / 2, config.brainShape, SeedChain(rng.next()))
+		: config.genome == "neat"
+		? Bird(world.birdX, world.height / 2, config.brainShape, Topology(config.brainShape.front(), config.brainShape.back(), config.addNodeChance, config.addConnectionChance, rng))
+		: Bird(world.birdX, world.height / 2, config.brainShape, rng);
+	if (config.selfAdaptive) {
+		// spread the starting rates so selection has something to choose between from the first generation
+		b.adaptMutation(config.mutationChance * std::exp(0.5f * rng.normal()), config.mutationStep * std::exp(0.5f * rng.normal()));
+	}
+	return b;
+}
+
+// Population mean and range of the self-adapted mutation rates
+void printMutationRates(const std::vector<Bird>& birds) {
+	float chance = 0, step = 0;
+	float minChance = 1e9f, maxChance = 0, minStep = 1e9f, maxStep = 0;
+	int n = 0;
+	for (const Bird& b : birds) {
+		if (!b.adaptsMutation())
+			continue;
+		n++;
+		chance += b.mutationChance();
+		step += b.mutationStep();
+		minChance = std::min(minChance, b.mutationChance());
+		maxChance = std::max(maxChance, b.mutationChance());
+		minStep = std::min(minStep, b.mutationStep());
+		maxStep = std::max(maxStep, b.mutationStep());
+	}
+	if (n == 0)
+		return;
+	std::cout << "MUTATION CHANCE: " << chance / n << " (" << minChance << " - " << maxChance << "), STEP: "
+		<< step / n << " (" << minStep << " - " << maxStep << ")\n";
+}
+
+// Sets up evolution as described by config and fills it with config.population random birds
+void initEvolution(Evolution<Bird>& evolution, const Config& config, const World& world, Rng& rng) {
+	evolution.seed(rng.next());
+	evolution.setSelection(makeSelection(config.selection, config.tournamentSize, config.rankPressure));
+	evolution.setMutation(config.mutationChance, config.mutationStep);
+	for (int i = 0; i < config.population; i++) {
+		evolution.addAgent(makeBird(config, world, rng));
+	}
+}
+
+// Population checkpoint: u32 count, then per bird f32 fitness and its genome (Bird::writeGenome).
+// Seed-chain lineages are shared, so a chain genome mostly costs its own latest mutation.
+bool saveGenomes(const std::string& path, const std::vector<Bird>& birds) {
+	ByteWriter out;
+	SeedChain::WriteTable chains;
+	out.u32(birds.size());
+	for (const Bird& b : birds) {
+		out.f32(b.fitness);
+		b.writeGenome(out, chains);
+	}
+	std::ofstream file(path, std::ios::binary);
+	file.write((const char*)out.bytes.data(), out.bytes.size());
+	return (bool)file;
+}
+
+// Replaces the genomes of the first birds with the checkpoint's, keeping the population size
+bool loadGenomes(const std::string& path, std::vector<Bird>& birds, const std::vector<int>& brainShape) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	ByteReader in(bytes);
+	SeedChain::ReadTable chains;
+	int n = std::min((int)in.u32(), (int)birds.size());
+	for (int i = 0; i < n; i++) {
+		birds[i].fitness = in.f32();
+		if (!birds[i].readGenome(in, brainShape, chains))
+			return false;
+		birds[i].reset();
+	}
+	return in.ok;
+}
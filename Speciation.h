@@ -0,0 +1,159 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "Random.h"
+#include "Simulation.h"
+#include "ThreadPool.h"
+
+// NEAT-style speciation with explicit fitness sharing. Genomes are compared by compatibility distance: the mean
+// absolute weight difference for fixed-shape brains, Topology::distance for grown ones. Each species is represented
+// by one member of the previous generation, and a bird joins the first species whose representative is within
+// threshold or founds a new one. Distances stop accumulating as soon as they pass the threshold, so most
+// comparisons read only a few weights and assignment costs O(N * species) instead of O(N^2).
+// Every bird's fitness is then divided by its species' size, so a new lineage isn't bred out by a crowd.
+// A threshold of 0 is calibrated on the first generation from a sample of pairwise distances: the quantile p
+// at which target founders leave about one of N birds unmatched, (1 - p)^target = 1 / N. A fixed guess would
+// found a species per few birds when it sits below the typical distance between random genomes (and founding
+// is the serial, O(N * species) part).
+class Speciation {
+	struct Species {
+		Bird representative;
+		int size;
+	};
+
+	float threshold;
+	int target;
+	Rng rng;
+	std::vector<Species> species;
+	std::vector<int> assigned;	// species of every bird of the current generation
+
+	// compatibility distance, or anything above limit once it's known to be above limit
+	static float distance(const Bird& x, const Bird& y, float limit) {
+		if (x.getTopology() && y.getTopology())
+			return Topology::distance(*x.getTopology(), *y.getTopology(), limit);
+		const float* a = x.getBrain().getWeights().data();
+		const float* b = y.getBrain().getWeights().data();
+		int n = x.getBrain().getWeights().size();
+		float bound = limit * n;
+		float sum = 0;
+		for (int base = 0; base < n; base += 16) {
+			int end = std::min(base + 16, n);
+			for (int i = base; i < end; i++) {
+				sum += std::abs(a[i] - b[i]);
+			}
+			if (sum > bound)
+				break;
+		}
+		return sum / n;
+	}
+
+	int match(const Bird& b, int from, int to) const {
+		for (int s = from; s < to; s++) {
+			if (distance(b, species[s].representative, threshold) <= threshold)
+				return s;
+		}
+		return -1;
+	}
+
+	// sets threshold to the 1 - N^(-1 / target) quantile of the distances between sampled pairs of birds
+	void calibrate(std::vector<Bird>& birds) {
+		int n = birds.size();
+		std::vector<float> d;
+		for (int p = 0; p < 256 && n > 1; p++) {
+			int a = rng.range(0, n - 1);
+			int b = rng.range(0, n - 2);
+			if (b >= a)
+				b++;
+			birds[a].materialise();
+			birds[b].materialise();
+			d.push_back(distance(birds[a], birds[b], INFINITY));
+		}
+		threshold = 1e-3f;
+		if (d.empty())
+			return;
+		float p = 1 - std::pow((float)n, -1.0f / std::max(target, 2));
+		int q = std::min((int)(p * d.size()), (int)d.size() - 1);
+		std::nth_element(d.begin(), d.begin() + q, d.end());
+		threshold = std::max(d[q], 1e-3f);
+	}
+
+public:
+	// threshold 0 is calibrated on the first generation; target > 0 adjusts threshold every generation to keep
+	// about that many species
+	Speciation(float threshold, int target, uint64_t seed) : threshold(threshold), target(target), rng(seed) {}
+
+	// Assigns every bird to a species and replaces its fitness with the shared fitness
+	void share(std::vector<Bird>& birds, ThreadPool* pool = nullptr) {
+		int n = birds.size();
+		if (n == 0)
+			return;
+		assigned.assign(n, -1);
+		if (threshold <= 0)
+			calibrate(birds);
+
+		// against last generation's representatives: read-only, so in parallel (once every bird has its weights)
+		int known = species.size();
+		auto assign = [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				birds[i].materialise();
+				assigned[i] = match(birds[i], 0, known);
+			}
+		};
+		if (pool)
+			pool->parallelFor(n, assign);
+		else
+			assign(0, n);
+
+		// the rest found species in order, each new one represented by its founder
+		for (int i = 0; i < n; i++) {
+			if (assigned[i] >= 0)
+				continue;
+			assigned[i] = match(birds[i], known, species.size());
+			if (assigned[i] < 0) {
+				assigned[i] = species.size();
+				species.push_back({ birds[i], 0 });
+			}
+		}
+
+		std::vector<std::vector<int>> members(species.size());
+		for (int i = 0; i < n; i++) {
+			members[assigned[i]].push_back(i);
+		}
+		for (int i = 0; i < n; i++) {
+			birds[i].fitness /= members[assigned[i]].size();
+		}
+
+		// extinct species go, the others are represented by a random member next generation
+		std::vector<Species> next;
+		for (int s = 0; s < species.size(); s++) {
+			if (members[s].empty())
+				continue;
+			next.push_back({ birds[members[s][rng.range(0, members[s].size() - 1)]], (int)members[s].size() });
+		}
+		species.swap(next);
+
+		if (target > 0) {
+			if (species.size() > target)
+				threshold *= 1.1f;
+			else if (species.size() < target)
+				threshold /= 1.1f;
+		}
+	}
+
+	int count() const {
+		return species.size();
+	}
+
+	int largest() const {
+		int m = 0;
+		for (const Species& s : species) {
+			m = std::max(m, s.size);
+		}
+		return m;
+	}
+
+	float compatibilityThreshold() const {
+		return threshold;
+	}
+};
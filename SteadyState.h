@@ -0,0 +1,133 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include "Config.h"
+#include "Selection.h"
+#include "Simulation.h"
+#include "ThreadPool.h"
+
+// Steady-state evolution: there are no generations. Every slot flies its own course, and the moment its
+// bird dies the bird is retired towards the parent pool (the last population finished birds) and the slot is
+// refilled with a child of two pool parents on a fresh course. No slot ever waits for a long-lived bird.
+//
+// Retired birds are staged and join the pool in groups of a tenth of its size, each time followed by one preparation
+// of selection, so a retirement costs one breeding plus an amortised O(1) share of the preparation.
+class SteadyState {
+	Config config;
+	World world;
+	std::vector<Bird> birds;
+	std::vector<Course> courses;
+	std::vector<Bird> pool;
+	int poolNext = 0;
+	// retired since selection was last prepared, waiting to join the pool
+	std::vector<Bird> staged;
+	std::unique_ptr<Selection> selection;
+	std::vector<float> fitness;
+	// refills so far; each takes the next pair of draws, so children made in the same tick get different parents
+	long long refills = 0;
+	std::vector<int> dead;
+	Rng rng;
+	ThreadPool* threads = nullptr;
+
+	void retire(int slot) {
+		const Bird& b = birds[slot];
+		staged.push_back(b);
+		staged.back().shelve();
+		best = std::max(best, b.fitness);
+		retired++;
+	}
+
+	// moves the staged birds into the parent pool (overwriting the oldest once it is full) and prepares
+	// selection over it; the pool only changes here, so every prepared index still means the same bird
+	void admit() {
+		for (Bird& b : staged) {
+			if (pool.size() < config.population) {
+				pool.push_back(std::move(b));
+			}
+			else {
+				pool[poolNext] = std::move(b);
+				poolNext = (poolNext + 1) % pool.size();
+			}
+		}
+		staged.clear();
+		int m = selection->objectives();
+		fitness.resize(pool.size() * m);
+		for (int i = 0; i < pool.size(); i++) {
+			pool[i].objectives(&fitness[i * m], m);
+		}
+		selection->prepare(fitness, config.population * 2, rng);
+	}
+
+	void refill(int slot) {
+		if (pool.empty() || staged.size() >= std::max(1, (int)pool.size() / 10))
+			admit();
+
+		Rng childRng(rng.next());
+		int draw = 2 * (int)(refills++ % config.population);
+		const Bird& a = pool[selection->select(draw, childRng)];
+		const Bird& b = pool[selection->select(draw + 1, childRng)];
+		birds[slot].breed(a, b, config.mutationChance, config.mutationStep, childRng);
+		courses[slot].reset(rng.next());
+		birds[slot].pos = { (float)world.birdX, world.height / 2.0f };
+	}
+
+public:
+	float best = 0;
+	long long retired = 0;
+
+	SteadyState(const Config& config, const World& world, Rng& seeder) : config(config), world(world), rng(seeder.next()) {
+		selection = makeSelection(config.selection, config.tournamentSize, config.rankPressure);
+		birds.reserve(config.population);
+		courses.reserve(config.population);
+		pool.reserve(config.population);
+		for (int i = 0; i < config.population; i++) {
+			birds.push_back(makeBird(config, world, rng));
+			courses.emplace_back(world, rng.next());
+		}
+	}
+
+	void setThreadPool(ThreadPool* p) {
+		threads = p;
+	}
+
+	// one tick: every slot flies (in parallel when there is a thread pool), then the dead are replaced
+	void step(float elapsedTime) {
+		auto flyRange = [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				courses[i].step(birds[i], elapsedTime);
+				if (courses[i].time >= config.maxGenTime)
+					birds[i].alive = false;
+			}
+		};
+		if (threads)
+			threads->parallelFor(birds.size(), flyRange);
+		else
+			flyRange(0, birds.size());
+
+		dead.clear();
+		for (int i = 0; i < birds.size(); i++) {
+			if (!birds[i].alive)
+				dead.push_back(i);
+		}
+		for (int slot : dead) {
+			retire(slot);
+		}
+		for (int slot : dead) {
+			refill(slot);
+		}
+	}
+
+	std::vector<Bird>& getBirds() {
+		return birds;
+	}
+
+	// the course of the bird that has been alive the longest
+	Course& leaderCourse() {
+		int leader = 0;
+		for (int i = 1; i < courses.size(); i++) {
+			if (courses[i].time > courses[leader].time)
+				leader = i;
+		}
+		return courses[leader];
+	}
+};
@@ -0,0 +1,172 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include "Random.h"
+#include "Simulation.h"
+#include "ThreadPool.h"
+#include "Novelty.h"
+
+// Cheap fitness predictor used to skip simulating children that are unlikely to matter.
+// A genome is described by its brain's flap output on a fixed set of probe inputs (what it would do in a
+// few sampled situations), and fitness is predicted as the distance-weighted mean of the k nearest past
+// genomes in a ring of the last memory (features, fitness) pairs. Learning is just storing the pairs of
+// birds that really flew. A memory of about two generations works best: older pairs were flown by a
+// population the current one no longer resembles. The ring is capped at maxMemory pairs and indexed by a
+// k-d tree rebuilt after every learn(), so a prediction costs O(log memory) rather than a scan of it.
+class Surrogate {
+	static constexpr int maxMemory = 16384;
+
+	int probes;
+	int memory;
+	int k;
+	std::vector<std::vector<float>> probeInputs;
+	std::vector<float> pastFeatures;	// memory rows of probes values
+	std::vector<float> pastFitness;
+	int stored = 0;
+	int next = 0;
+	KDTree index;	// over the stored rows of pastFeatures
+
+	std::vector<float> features;	// per bird of the current generation
+	std::vector<float> predicted;
+	std::vector<bool> flown;
+
+	void describe(Bird& b, float* out) {
+		for (int p = 0; p < probes; p++) {
+			out[p] = b.think(probeInputs[p]);
+		}
+	}
+
+	float predict(const float* f) const {
+		std::vector<std::pair<float, int>> nearest;
+		index.nearest(f, k, nearest);
+		float sum = 0, weight = 0;
+		for (auto& n : nearest) {
+			float w = 1 / (std::sqrt(n.first) + 1e-3f);
+			sum += w * pastFitness[n.second];
+			weight += w;
+		}
+		return weight > 0 ? sum / weight : 0;
+	}
+
+	// Spearman rank correlation of a and b
+	static float rankCorrelation(const std::vector<float>& a, const std::vector<float>& b) {
+		int n = a.size();
+		if (n < 2)
+			return 0;
+		auto ranks = [n](const std::vector<float>& v) {
+			std::vector<int> order(n);
+			std::iota(order.begin(), order.end(), 0);
+			std::sort(order.begin(), order.end(), [&](int x, int y) { return v[x] < v[y]; });
+			std::vector<float> r(n);
+			for (int i = 0; i < n;) {
+				int j = i;
+				while (j + 1 < n && v[order[j + 1]] == v[order[i]])
+					j++;
+				for (int t = i; t <= j; t++) {
+					r[order[t]] = (i + j) / 2.0f;
+				}
+				i = j + 1;
+			}
+			return r;
+		};
+		std::vector<float> ra = ranks(a), rb = ranks(b);
+		float mean = (n - 1) / 2.0f;
+		float cov = 0, va = 0, vb = 0;
+		for (int i = 0; i < n; i++) {
+			cov += (ra[i] - mean) * (rb[i] - mean);
+			va += (ra[i] - mean) * (ra[i] - mean);
+			vb += (rb[i] - mean) * (rb[i] - mean);
+		}
+		return va > 0 && vb > 0 ? cov / std::sqrt(va * vb) : 0;
+	}
+
+public:
+	float accuracy = 0;	// rank correlation of prediction and real fitness over last generation's flown birds
+	long long screened = 0;
+	long long flownTotal = 0;
+
+	Surrogate(int inputs, int memory, uint64_t seed, int probes = 16, int k = 10)
+		: probes(probes), memory(std::min(std::max(1, memory), maxMemory)), k(k),
+		  pastFeatures(this->memory * probes), pastFitness(this->memory), index(probes) {
+		Rng rng(seed);
+		probeInputs.resize(probes, std::vector<float>(inputs));
+		for (auto& input : probeInputs) {
+			for (int i = 0; i < inputs; i++) {
+				// roughly the ranges the course feeds: heights in [0,1], vertical speed (1) around 0,
+				// distance to the pipe (2) within a pipe gap
+				input[i] = i == 1 ? rng.uniform2() * 0.3f : i == 2 ? rng.uniform() * 0.35f : rng.uniform();
+			}
+		}
+	}
+
+	bool warm(int population) const {
+		return stored >= std::min(memory, 2 * population);
+	}
+
+	// Predicts every living bird and grounds all but the best keep share of them: they are marked dead
+	// with the prediction as fitness, so the flight skips them. Does nothing until the model has seen
+	// two generations. Birds are described and predicted on pool if given.
+	void screen(std::vector<Bird>& birds, float keep, ThreadPool* pool = nullptr) {
+		int n = birds.size();
+		features.resize(n * probes);
+		predicted.assign(n, 0);
+		flown.assign(n, true);
+		bool ready = warm(n);
+		auto estimate = [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				describe(birds[i], &features[i * probes]);
+				if (ready)
+					predicted[i] = predict(&features[i * probes]);
+			}
+		};
+		if (pool)
+			pool->parallelFor(n, estimate);
+		else
+			estimate(0, n);
+		if (!ready)
+			return;
+
+		std::vector<int> order;
+		for (int i = 0; i < n; i++) {
+			if (birds[i].alive)
+				order.push_back(i);
+		}
+		int fly = (int)std::ceil(std::min(std::max(keep, 0.0f), 1.0f) * order.size());
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return predicted[a] > predicted[b]; });
+		for (int r = fly; r < order.size(); r++) {
+			Bird& b = birds[order[r]];
+			b.alive = false;
+			b.fitness = predicted[order[r]];
+			flown[order[r]] = false;
+			screened++;
+		}
+	}
+
+	// Learns from the birds screen() let fly (call after the flight, before breeding)
+	void learn(const std::vector<Bird>& birds) {
+		if (flown.size() != birds.size())
+			return;
+		bool scored = warm(birds.size());
+		std::vector<float> guess, real;
+		for (int i = 0; i < birds.size(); i++) {
+			if (!flown[i])
+				continue;
+			if (scored) {
+				guess.push_back(predicted[i]);
+				real.push_back(birds[i].fitness);
+			}
+			std::copy(&features[i * probes], &features[i * probes] + probes, &pastFeatures[next * probes]);
+			pastFitness[next] = birds[i].fitness;
+			next = (next + 1) % memory;
+			stored = std::min(stored + 1, memory);
+			flownTotal++;
+		}
+		index.assign(pastFeatures.data(), stored);
+		if (scored)
+			accuracy = rankCorrelation(guess, real);
+	}
+};
+
+constexpr int Surrogate::maxMemory;
@@ -0,0 +1,337 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include "Config.h"
+#include "Simulation.h"
+#include "ThreadPool.h"
+#include "Engines.h"
+#include "FitnessCache.h"
+#include "Surrogate.h"
+#include "Novelty.h"
+#include "Speciation.h"
+
+// The search space of a sweep, read from a file in config syntax with one searched key per line:
+//   key = a | b | c            these values (a grid tries every combination)
+//   key = uniform lo hi        random search only: uniform in [lo, hi], whole numbers if lo and hi are whole
+//   key = loguniform lo hi     random search only: log-uniform in [lo, hi]
+// Every other key keeps the value of the run's config. Lines with unknown keys, no values or unreadable
+// bounds are reported and skipped.
+class SweepSpace {
+	struct Axis {
+		std::string key;
+		std::vector<std::string> values;
+		std::string distribution;	// empty for a value list
+		double lo = 0;
+		double hi = 0;
+		bool whole = false;
+	};
+
+	std::vector<Axis> axes;
+
+public:
+	bool load(const std::string& path) {
+		std::ifstream file(path);
+		if (!file)
+			return false;
+		Config probe;
+		std::string line;
+		while (std::getline(file, line)) {
+			line = line.substr(0, line.find('#'));
+			size_t eq = line.find('=');
+			if (eq == std::string::npos)
+				continue;
+			Axis axis;
+			axis.key = Config::trim(line.substr(0, eq));
+			std::string value = Config::trim(line.substr(eq + 1));
+			std::istringstream in(value);
+			std::string first, lo, hi;
+			in >> first >> lo >> hi;
+			if ((first == "uniform" || first == "loguniform") && !hi.empty()) {
+				axis.distribution = first;
+				std::istringstream bounds(lo + ' ' + hi);
+				if (!(bounds >> axis.lo >> axis.hi)) {
+					std::cout << "Bad bounds for " << axis.key << ": " << value << '\n';
+					continue;
+				}
+				axis.whole = lo.find_first_of(".eE") == std::string::npos && hi.find_first_of(".eE") == std::string::npos;
+				axis.values = { lo };
+			}
+			else {
+				std::istringstream list(value);
+				std::string v;
+				while (std::getline(list, v, '|')) {
+					v = Config::trim(v);
+					if (!v.empty())
+						axis.values.push_back(v);
+				}
+			}
+			if (axis.values.empty()) {
+				std::cout << "No values for " << axis.key << '\n';
+				continue;
+			}
+			if (!probe.set(axis.key, axis.values[0])) {
+				std::cout << "Unknown config key: " << axis.key << '\n';
+				continue;
+			}
+			axes.push_back(axis);
+		}
+		return true;
+	}
+
+	// combinations in the grid (distributions count as their lower bound only)
+	long long gridSize() const {
+		long long n = 1;
+		for (const Axis& a : axes) {
+			n *= a.values.size();
+		}
+		return n;
+	}
+
+	// the index-th combination as "key = value" settings (mixed radix, last key fastest)
+	std::vector<std::pair<std::string, std::string>> gridPoint(long long index) const {
+		std::vector<std::pair<std::string, std::string>> point(axes.size());
+		for (int i = axes.size() - 1; i >= 0; i--) {
+			const Axis& a = axes[i];
+			point[i] = { a.key, a.values[index % a.values.size()] };
+			index /= a.values.size();
+		}
+		return point;
+	}
+
+	std::vector<std::pair<std::string, std::string>> sample(Rng& rng) const {
+		std::vector<std::pair<std::string, std::string>> point;
+		for (const Axis& a : axes) {
+			std::string value;
+			if (a.distribution.empty()) {
+				value = a.values[rng.range(0, a.values.size() - 1)];
+			}
+			else {
+				double u = rng.uniform();
+				bool log = a.distribution == "loguniform" && a.lo > 0;
+				// whole values are drawn from [lo, hi + 1) and rounded down, so hi is as reachable as lo
+				double top = a.whole ? a.hi + 1 : a.hi;
+				double x = log ? a.lo * std::pow(top / a.lo, u) : a.lo + (top - a.lo) * u;
+				std::ostringstream out;
+				if (a.whole)
+					out << (long long)std::floor(std::min(x, a.hi));
+				else
+					out << x;
+				value = out.str();
+			}
+			point.push_back({ a.key, value });
+		}
+		return point;
+	}
+};
+
+// One trial of a sweep: the run's config with the point's settings applied
+struct Trial {
+	int id;
+	Config config;
+	std::string parameters;	// the point as "key=value key=value"
+
+	Trial(int id, const Config& base, const std::vector<std::pair<std::string, std::string>>& point) : id(id), config(base) {
+		for (auto& setting : point) {
+			config.set(setting.first, setting.second);
+			parameters += (parameters.empty() ? "" : " ") + setting.first + "=" + setting.second;
+		}
+		config.threads = 1;
+	}
+};
+
+// what a trial reports after every generation
+struct GenerationSummary {
+	int generation;
+	float best;
+	float mean;
+	double seconds;
+};
+
+// One headless evolution run on the calling thread with nothing shared, as configured (engine, fitness cache,
+// racing, surrogate, novelty, speciation). report is called after every generation and stops the run by
+// returning false; returns the best score.
+template <typename Report>
+float runTrial(const Config& config, Report report) {
+	World world(config);
+	Rng rng(config.seed);
+	Evolution<Bird> evolution(config.population);
+	initEvolution(evolution, config, world, rng);
+	std::vector<Bird>& birds = evolution.getAgents();
+	std::unique_ptr<Optimizer> optimizer = makeOptimizer(config, rng);
+	std::unique_ptr<FitnessCache> cache;
+	std::unique_ptr<Surrogate> surrogate;
+	std::unique_ptr<NoveltySearch> novelty;
+	std::unique_ptr<Speciation> speciation;
+	if (config.fitnessCache > 0)
+		cache.reset(new FitnessCache(config.fitnessCache));
+	if (config.surrogate)
+		surrogate.reset(new Surrogate(config.brainShape[0], 2 * config.population, rng.next()));
+	if (config.novelty)
+		novelty.reset(new NoveltySearch(config.noveltyK, config.noveltyArchive));
+	if (config.speciation)
+		speciation.reset(new Speciation(config.speciesThreshold, config.speciesTarget, rng.next()));
+	std::vector<std::vector<float>> genomes;
+	std::vector<float> fitness;
+	if (optimizer)
+		askOptimizer(*optimizer, birds, genomes);
+
+	auto start = std::chrono::steady_clock::now();
+	float best = 0;
+	for (int gen = 0; gen < config.generations; gen++) {
+		uint64_t courseSeed = config.fixedCourse ? config.seed : rng.next();
+		if (surrogate)
+			surrogate->screen(birds, config.surrogateKeep);
+		float score = cache ? evaluate(birds, world, courseSeed, config, *cache) : evaluate(birds, world, courseSeed, config);
+		best = std::max(best, score);
+		if (surrogate)
+			surrogate->learn(birds);
+
+		float sum = 0;
+		for (const Bird& b : birds) {
+			sum += b.fitness;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (!report(GenerationSummary{ gen, score, sum / birds.size(), seconds }))
+			break;
+
+		if (novelty)
+			novelty->score(birds);
+		if (optimizer) {
+			tellOptimizer(*optimizer, birds, fitness);
+			askOptimizer(*optimizer, birds, genomes);
+		}
+		else {
+			if (speciation)
+				speciation->share(birds);
+			evolution.make_next_generation();
+		}
+	}
+	return best;
+}
+
+// Asynchronous successive halving (ASHA) for sweeps. Rung k is at firstRung * reduction^k generations; a trial
+// reaching a rung records its best score so far there and goes on only if it is in the top 1/reduction of the
+// scores recorded at that rung so far. Nobody waits for a rung to fill: early trials are judged against few
+// others (and kept generously), later ones against many, and no trial is ever held back by a slower one.
+class AsyncHalving {
+	int firstRung;
+	int reduction;
+	std::mutex mutex;
+	std::vector<std::vector<float>> rungs;
+
+public:
+	std::atomic<int> stopped{ 0 };
+
+	AsyncHalving(int firstRung, int reduction) : firstRung(std::max(1, firstRung)), reduction(std::max(2, reduction)) {}
+
+	// whether a trial that has run generations generations, scoring best so far, should go on
+	bool report(int generations, float best) {
+		int rung = 0;
+		for (long long at = firstRung; at <= generations; at *= reduction, rung++) {
+			if (at != generations)
+				continue;
+			std::lock_guard<std::mutex> lock(mutex);
+			if (rungs.size() <= rung)
+				rungs.resize(rung + 1);
+			std::vector<float>& scores = rungs[rung];
+			scores.push_back(best);
+			int better = 0;
+			for (float s : scores) {
+				better += s > best;
+			}
+			if (better < (scores.size() + reduction - 1) / reduction)
+				return true;
+			stopped++;
+			return false;
+		}
+		return true;
+	}
+};
+
+// Hyperparameter sweep (--sweep file): every trial is an independent runTrial, config.threads of them at a
+// time, each worker thread pinned to its own core. Trials are the whole grid, or config.sweepSamples random
+// points. Every generation of every trial is appended to config.sweepResults as it happens:
+//   trial,generation,best,mean,seconds,parameters
+// With config.sweepEarlyStop, AsyncHalving stops trials that fall behind at a rung.
+void runSweep(const Config& config, const std::string& spacePath) {
+	SweepSpace space;
+	if (!space.load(spacePath)) {
+		std::cout << "Can't read sweep " << spacePath << '\n';
+		return;
+	}
+	Rng rng(config.seed);
+	std::vector<Trial> trials;
+	if (config.sweepSamples > 0) {
+		for (int i = 0; i < config.sweepSamples; i++) {
+			trials.emplace_back(i, config, space.sample(rng));
+		}
+	}
+	else {
+		for (long long i = 0; i < space.gridSize(); i++) {
+			trials.emplace_back(i, config, space.gridPoint(i));
+		}
+	}
+
+	std::ofstream results(config.sweepResults);
+	if (!results) {
+		std::cout << "Can't write " << config.sweepResults << '\n';
+		return;
+	}
+	results << "trial,generation,best,mean,seconds,parameters\n";
+	std::mutex resultsMutex;
+	std::atomic<int> next{ 0 };
+	std::vector<float> bests(trials.size(), 0);
+	std::vector<int> flown(trials.size(), 0);
+	AsyncHalving halving(config.ashaFirstRung, config.ashaReduction);
+
+	auto work = [&](int worker) {
+		pinToCore(worker);
+		for (int t = next++; t < trials.size(); t = next++) {
+			const Trial& trial = trials[t];
+			float best = 0;
+			bests[t] = runTrial(trial.config, [&](const GenerationSummary& s) {
+				best = std::max(best, s.best);
+				flown[t] = s.generation + 1;
+				{
+					std::lock_guard<std::mutex> lock(resultsMutex);
+					results << trial.id << ',' << s.generation << ',' << s.best << ',' << s.mean << ',' << s.seconds << ",\"" << trial.parameters << "\"\n";
+					results.flush();
+				}
+				return !config.sweepEarlyStop || halving.report(s.generation + 1, best);
+			});
+			std::lock_guard<std::mutex> lock(resultsMutex);
+			std::cout << "TRIAL: " << trial.id << ", SCORE: " << bests[t] << ", GENERATIONS: " << flown[t] << ", " << trial.parameters << "\n";
+		}
+	};
+	int threads = config.threads > 0 ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+	threads = std::min<int>(threads, trials.size());
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; i++) {
+		workers.emplace_back(work, i);
+	}
+	for (std::thread& w : workers) {
+		w.join();
+	}
+
+	if (!trials.empty()) {
+		int best = std::max_element(bests.begin(), bests.end()) - bests.begin();
+		std::cout << "BEST TRIAL: " << best << ", SCORE: " << bests[best] << ", " << trials[best].parameters << "\n";
+	}
+	if (config.sweepEarlyStop) {
+		long long run = 0, budget = 0;
+		for (int t = 0; t < trials.size(); t++) {
+			run += flown[t];
+			budget += trials[t].config.generations;
+		}
+		std::cout << "STOPPED EARLY: " << halving.stopped << " of " << trials.size() << " trials, " << run << " of " << budget << " generations run\n";
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+// Best effort: keeps the calling thread on one core (wraps around the available cores)
+void pinToCore(int core) {
+	int cores = std::max(1u, std::thread::hardware_concurrency());
+	core %= cores;
+#if defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(_WIN32)
+	SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (core % (sizeof(DWORD_PTR) * 8)));
+#endif
+}
+
+// Fixed set of worker threads for data-parallel loops.
+// parallelFor hands out [begin,end) chunks of the index range; the calling thread works too and
+// returns once every chunk is done.
+class ThreadPool {
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+
+	std::function<void(int, int)> job;
+	int jobSize = 0;
+	int grain = 1;
+	std::atomic<int> nextIndex{ 0 };
+	unsigned jobId = 0;
+	int busy = 0;
+	bool stop = false;
+
+	void runChunks() {
+		while (true) {
+			int begin = nextIndex.fetch_add(grain);
+			if (begin >= jobSize)
+				break;
+			job(begin, std::min(begin + grain, jobSize));
+		}
+	}
+
+	void workerLoop() {
+		unsigned seen = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return stop || jobId != seen; });
+				if (stop)
+					return;
+				seen = jobId;
+				if (nextIndex >= jobSize)
+					continue;
+				busy++;
+			}
+			runChunks();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				busy--;
+			}
+			finished.notify_all();
+		}
+	}
+
+public:
+	// nThreads counts the calling thread, 0 means one per hardware thread
+	ThreadPool(int nThreads = 0) {
+		if (nThreads <= 0)
+			nThreads = std::max(1u, std::thread::hardware_concurrency());
+		for (int i = 1; i < nThreads; i++) {
+			workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		wake.notify_all();
+		for (std::thread& t : workers) {
+			t.join();
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	int size() const {
+		return workers.size() + 1;
+	}
+
+	void parallelFor(int n, const std::function<void(int, int)>& f, int chunk = 0) {
+		if (n <= 0)
+			return;
+		if (chunk <= 0)
+			chunk = std::max(1, n / (size() * 4));
+		if (workers.empty() || n <= chunk) {
+			f(0, n);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = f;
+			jobSize = n;
+			grain = chunk;
+			nextIndex = 0;
+			jobId++;
+		}
+		wake.notify_all();
+		runChunks();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [&] { return busy == 0 && nextIndex >= jobSize; });
+		job = nullptr;
+	}
+};
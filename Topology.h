@@ -0,0 +1,390 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include "olcPixelGameEngine.h"
+#include "Random.h"
+#include "Serialize.h"
+#include "NeuralNetwork.h"
+
+// A Topology compiled for running: every computed node in topological order, each followed in links by its
+// incoming (source slot, weight) pairs. The forward pass is one walk over two contiguous arrays.
+// slots: the inputs, the bias (always 1), the outputs, then the hidden nodes
+class Plan {
+public:
+	struct Link {
+		int source;
+		float weight;
+	};
+	struct Node {
+		int slot;
+		int count;
+	};
+
+	int inputs = 0;
+	std::vector<float> values;
+	std::vector<Node> nodes;
+	std::vector<Link> links;
+	std::vector<int> depth;	// per slot: longest path from an input (for drawing)
+
+	// returns the first output
+	float run(const std::vector<float>& input) {
+		float* v = values.data();
+		for (int i = 0; i < inputs; i++) {
+			v[i] = input[i];
+		}
+		const Link* l = links.data();
+		for (const Node& n : nodes) {
+			float sum = 0;
+			for (const Link* end = l + n.count; l < end; l++) {
+				sum += v[l->source] * l->weight;
+			}
+			v[n.slot] = sigmoid(sum);
+		}
+		return v[inputs + 1];
+	}
+
+	void draw(olc::PixelGameEngine* canvas, int x, int y) const {
+		const int nodeR = 10;
+		const int layerGap = 60;
+		const int nodeGap = 20;
+		std::vector<olc::vi2d> positions(values.size());
+		std::vector<int> filled;
+		for (int s = 0; s < values.size(); s++) {
+			if (depth[s] >= filled.size())
+				filled.resize(depth[s] + 1, 0);
+			positions[s] = { x + nodeR + depth[s] * (2 * nodeR + layerGap), y + nodeR + filled[depth[s]]++ * (2 * nodeR + nodeGap) };
+		}
+		const Link* l = links.data();
+		for (const Node& n : nodes) {
+			for (const Link* end = l + n.count; l < end; l++) {
+				float shade = std::min(std::max((l->weight + 1) / 2, 0.0f), 1.0f) * 255;
+				canvas->DrawLine(positions[l->source], positions[n.slot], olc::Pixel(shade, shade, shade));
+			}
+		}
+		for (const olc::vi2d& p : positions) {
+			canvas->FillCircle(p, nodeR, olc::GREY);
+		}
+	}
+};
+
+// NEAT-style genome: a list of connection genes, grown by mutations that add a connection or split one with
+// a new node. Node ids: inputs 0..inputs-1, the bias, the outputs, hidden nodes have the top bit set.
+// A gene's innovation number is its (from, to) pair and a split's node id is derived from the split gene,
+// so the same innovation made independently on any island, thread or process lines up in crossover without
+// a shared registry. Genes are kept sorted by innovation and the graph (disabled genes included) is acyclic.
+class Topology {
+	struct Gene {
+		uint64_t key;	// from << 32 | to
+		float weight;
+		bool enabled;
+	};
+
+	static const uint32_t hidden = 0x80000000u;
+
+	int inputs = 0;
+	int outputs = 0;
+	float addNode = 0;	// chance of a node mutation per child
+	float addConnection = 0;	// chance of a connection mutation per child
+	std::vector<Gene> genes;
+
+	static uint64_t link(uint32_t from, uint32_t to) {
+		return (uint64_t)from << 32 | to;
+	}
+
+	static uint32_t from(uint64_t key) {
+		return key >> 32;
+	}
+
+	static uint32_t to(uint64_t key) {
+		return (uint32_t)key;
+	}
+
+	bool isOutput(uint32_t id) const {
+		return id > inputs && id <= inputs + outputs;
+	}
+
+	// every node id: inputs, bias and outputs first, then the hidden nodes in id order
+	std::vector<uint32_t> nodeIds() const {
+		std::vector<uint32_t> ids;
+		for (uint32_t i = 0; i <= inputs + outputs; i++) {
+			ids.push_back(i);
+		}
+		for (const Gene& g : genes) {
+			ids.push_back(from(g.key));
+			ids.push_back(to(g.key));
+		}
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+		return ids;
+	}
+
+	const Gene* find(uint64_t key) const {
+		auto it = std::lower_bound(genes.begin(), genes.end(), key, [](const Gene& g, uint64_t k) { return g.key < k; });
+		return it != genes.end() && it->key == key ? &*it : nullptr;
+	}
+
+	void add(uint64_t key, float weight) {
+		auto it = std::lower_bound(genes.begin(), genes.end(), key, [](const Gene& g, uint64_t k) { return g.key < k; });
+		genes.insert(it, { key, weight, true });
+	}
+
+	// whether target can be reached from start
+	bool reaches(uint32_t start, uint32_t target) const {
+		std::vector<uint32_t> stack = { start }, seen;
+		while (!stack.empty()) {
+			uint32_t id = stack.back();
+			stack.pop_back();
+			if (id == target)
+				return true;
+			if (std::find(seen.begin(), seen.end(), id) != seen.end())
+				continue;
+			seen.push_back(id);
+			auto it = std::lower_bound(genes.begin(), genes.end(), link(id, 0), [](const Gene& g, uint64_t k) { return g.key < k; });
+			for (; it != genes.end() && from(it->key) == id; it++) {
+				stack.push_back(to(it->key));
+			}
+		}
+		return false;
+	}
+
+	void addConnectionMutation(Rng& rng) {
+		std::vector<uint32_t> ids = nodeIds();
+		for (int attempt = 0; attempt < 20; attempt++) {
+			uint32_t a = ids[rng.range(0, ids.size() - 1)];
+			uint32_t b = ids[rng.range(inputs + 1, ids.size() - 1)];
+			if (a == b || isOutput(a) || find(link(a, b)) || reaches(b, a))
+				continue;
+			add(link(a, b), rng.uniform2());
+			return;
+		}
+	}
+
+	void addNodeMutation(Rng& rng) {
+		std::vector<int> enabled;
+		for (int i = 0; i < genes.size(); i++) {
+			if (genes[i].enabled)
+				enabled.push_back(i);
+		}
+		if (enabled.empty())
+			return;
+		Gene split = genes[enabled[rng.range(0, enabled.size() - 1)]];
+		uint64_t h = split.key * 0x9E3779B97F4A7C15ull;
+		uint32_t node = hidden | (uint32_t)(h >> 33);
+		std::vector<uint32_t> ids = nodeIds();
+		if (std::binary_search(ids.begin(), ids.end(), node))
+			return;
+		for (Gene& g : genes) {
+			if (g.key == split.key)
+				g.enabled = false;
+		}
+		add(link(from(split.key), node), 1);
+		add(link(node, to(split.key)), split.weight);
+	}
+
+public:
+	Topology() {}
+
+	// the minimal network: every input and the bias connected straight to every output
+	Topology(int inputs, int outputs, float addNode, float addConnection, Rng& rng)
+		: inputs(inputs), outputs(outputs), addNode(addNode), addConnection(addConnection) {
+		for (uint32_t a = 0; a <= inputs; a++) {
+			for (uint32_t b = inputs + 1; b <= inputs + outputs; b++) {
+				genes.push_back({ link(a, b), rng.uniform2(), true });
+			}
+		}
+	}
+
+	// Perturbs each weight with probability chance by up to lr, then maybe adds a connection and a node
+	void mutate(float chance, float lr, Rng& rng) {
+		int n = genes.size();
+		for (int i = rng.geometric(chance); i < n; ) {
+			genes[i].weight += rng.uniform2() * lr;
+			int skip = rng.geometric(chance);
+			if (skip >= n - i)
+				break;
+			i += skip + 1;
+		}
+		if (rng.uniform() < addConnection)
+			addConnectionMutation(rng);
+		if (rng.uniform() < addNode)
+			addNodeMutation(rng);
+	}
+
+	// NEAT crossover into child: the structure of the fitter parent, matching genes take either parent's
+	// weight, and a gene disabled in either parent stays disabled three times out of four
+	static void cross(const Topology& fitter, const Topology& other, Topology& child, Rng& rng) {
+		child.inputs = fitter.inputs;
+		child.outputs = fitter.outputs;
+		child.addNode = fitter.addNode;
+		child.addConnection = fitter.addConnection;
+		child.genes.resize(fitter.genes.size());
+		int j = 0;
+		for (int i = 0; i < fitter.genes.size(); i++) {
+			const Gene& g = fitter.genes[i];
+			while (j < other.genes.size() && other.genes[j].key < g.key)
+				j++;
+			Gene& c = child.genes[i];
+			c = g;
+			if (j < other.genes.size() && other.genes[j].key == g.key) {
+				const Gene& m = other.genes[j];
+				if (rng.next() & 1)
+					c.weight = m.weight;
+				if (!g.enabled || !m.enabled)
+					c.enabled = rng.uniform() < 0.25f;
+			}
+		}
+	}
+
+	// NEAT compatibility distance: share of unmatched genes plus the mean weight difference of matched ones.
+	// Anything above limit is returned as soon as the unmatched share alone passes it.
+	static float distance(const Topology& a, const Topology& b, float limit) {
+		int n = std::max(a.genes.size(), b.genes.size());
+		if (n == 0)
+			return 0;
+		int unmatched = 0, matched = 0;
+		float diff = 0;
+		int i = 0, j = 0;
+		while (i < a.genes.size() || j < b.genes.size()) {
+			if (j == b.genes.size() || (i < a.genes.size() && a.genes[i].key < b.genes[j].key)) {
+				i++;
+				unmatched++;
+			}
+			else if (i == a.genes.size() || b.genes[j].key < a.genes[i].key) {
+				j++;
+				unmatched++;
+			}
+			else {
+				diff += std::abs(a.genes[i++].weight - b.genes[j++].weight);
+				matched++;
+				continue;
+			}
+			if ((float)unmatched / n > limit)
+				break;
+		}
+		return (float)unmatched / n + (matched ? diff / matched : 0);
+	}
+
+	// Builds the execution plan, reusing plan's storage
+	void compile(Plan& plan) const {
+		std::vector<uint32_t> ids = nodeIds();
+		int n = ids.size();
+		auto slot = [&](uint32_t id) { return (int)(std::lower_bound(ids.begin(), ids.end(), id) - ids.begin()); };
+		std::vector<std::vector<Plan::Link>> incoming(n);
+		std::vector<std::vector<int>> outgoing(n);
+		std::vector<int> pending(n, 0);
+		for (const Gene& g : genes) {
+			if (!g.enabled)
+				continue;
+			int s = slot(from(g.key)), t = slot(to(g.key));
+			incoming[t].push_back({ s, g.weight });
+			outgoing[s].push_back(t);
+			pending[t]++;
+		}
+
+		plan.inputs = inputs;
+		plan.values.assign(n, 0);
+		plan.values[inputs] = 1;
+		plan.depth.assign(n, 0);
+		plan.nodes.clear();
+		plan.links.clear();
+		std::vector<int> ready;
+		for (int s = 0; s < n; s++) {
+			if (pending[s] == 0)
+				ready.push_back(s);
+		}
+		for (int r = 0; r < ready.size(); r++) {
+			int s = ready[r];
+			if (s > inputs) {
+				plan.nodes.push_back({ s, (int)incoming[s].size() });
+				plan.links.insert(plan.links.end(), incoming[s].begin(), incoming[s].end());
+			}
+			for (int t : outgoing[s]) {
+				plan.depth[t] = std::max(plan.depth[t], plan.depth[s] + 1);
+				if (--pending[t] == 0)
+					ready.push_back(t);
+			}
+		}
+	}
+
+	int connections() const {
+		int c = 0;
+		for (const Gene& g : genes) {
+			c += g.enabled;
+		}
+		return c;
+	}
+
+	// mean |weight| over the enabled genes (0 without any)
+	float meanWeight() const {
+		float sum = 0;
+		int n = 0;
+		for (const Gene& g : genes) {
+			if (g.enabled) {
+				sum += std::abs(g.weight);
+				n++;
+			}
+		}
+		return n ? sum / n : 0;
+	}
+
+	int hiddenNodes() const {
+		return nodeIds().size() - inputs - outputs - 1;
+	}
+
+	int size() const {
+		return genes.size();
+	}
+
+	uint64_t hash() const {
+		uint64_t h = 0x13198A2E03707344ull ^ genes.size();
+		for (const Gene& g : genes) {
+			uint32_t w;
+			std::memcpy(&w, &g.weight, 4);
+			h = (h ^ g.key) * 0x9E3779B97F4A7C15ull;
+			h = (h ^ ((uint64_t)w << 1 | g.enabled)) * 0xBF58476D1CE4E5B9ull;
+			h ^= h >> 29;
+		}
+		return h ^ (h >> 31);
+	}
+
+	// binary form: u16 inputs, u16 outputs, f32 node and connection mutation chances, u32 gene count,
+	// then u64 innovation, f32 weight and u8 enabled per gene
+	void write(ByteWriter& out) const {
+		out.u16(inputs);
+		out.u16(outputs);
+		out.f32(addNode);
+		out.f32(addConnection);
+		out.u32(genes.size());
+		for (const Gene& g : genes) {
+			out.u64(g.key);
+			out.f32(g.weight);
+			out.u8(g.enabled);
+		}
+	}
+
+	// returns false on a malformed buffer or other input/output counts
+	static bool read(ByteReader& in, int inputs, int outputs, Topology& out) {
+		if (in.u16() != inputs || in.u16() != outputs)
+			return false;
+		out.inputs = inputs;
+		out.outputs = outputs;
+		out.addNode = in.f32();
+		out.addConnection = in.f32();
+		uint32_t n = in.u32();
+		if (!in.ok || n > in.remaining() / 13)
+			return false;
+		out.genes.resize(n);
+		for (int i = 0; i < n; i++) {
+			Gene& g = out.genes[i];
+			g.key = in.u64();
+			g.weight = in.f32();
+			g.enabled = in.u8();
+			if (i > 0 && g.key <= out.genes[i - 1].key)
+				return false;
+		}
+		return in.ok;
+	}
+};